@@ -0,0 +1,367 @@
+//
+//  bench.c
+//  Per-entrypoint microbenchmarks for the native contract builds
+//
+//  usage: bench [-a] [iterations] [filter]
+//
+//  -a: break host calls down per entrypoint and storage prefix after each row
+//
+//  warm: every op touches accounts from a small working set already in storage
+//  cold: every op touches an account storage has not seen before
+//
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "host.h"
+#include "contracts.h"
+#include "accounting.h"
+
+#define DEFAULT_ITERATIONS 200000
+#define WARM_ACCOUNTS 64
+#define FIRST_ACCOUNT 16
+#define OWNER_ACCOUNT 0
+#define SPENDER_ACCOUNT 1
+
+typedef struct {
+  const char *contract;
+  const char *entrypoint;
+  const char *state;
+  // Build the starting state for n ops
+  void (*setup)(host_t *host, size_t n);
+  // Untimed work before op i, NULL if none
+  void (*prepare)(host_t *host, size_t i);
+  int (*op)(host_t *host, size_t i);
+} bench_t;
+
+static uint8_t (*accounts)[ADDRESS_SIZE];
+static int with_accounting;
+
+static uint8_t *_account(size_t i) {
+  return accounts[i];
+}
+
+static uint8_t *_warm(size_t i) {
+  return accounts[FIRST_ACCOUNT + i % WARM_ACCOUNTS];
+}
+
+static uint8_t *_cold(size_t i) {
+  return accounts[FIRST_ACCOUNT + WARM_ACCOUNTS + i];
+}
+
+static void _build_accounts(size_t n) {
+  size_t count = FIRST_ACCOUNT + WARM_ACCOUNTS + n;
+  accounts = calloc(count, ADDRESS_SIZE);
+  for (size_t i = 0; i < count; i++) {
+    accounts[i][0] = 88;
+    memcpy(accounts[i] + 1, &i, sizeof(i));
+  }
+}
+
+static uint64_t _now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// qash
+
+// Setup helpers run one invocation each so loops stay clear of setjmp
+
+static void _qash_mint(host_t *host, uint8_t *to, uint64_t value) {
+  int status;
+  HOST_INVOKE(host, status, qash_mint(to, value));
+  (void)status;
+}
+
+static void _qash_approve(host_t *host, uint8_t *spender, uint64_t value) {
+  int status;
+  HOST_INVOKE(host, status, qash_approve(spender, value));
+  (void)status;
+}
+
+static void _token_transfer(host_t *host, uint8_t *to, uint64_t amount) {
+  int status;
+  HOST_INVOKE(host, status, token_transfer(to, amount));
+  (void)status;
+}
+
+static void _erc20_transfer(host_t *host, uint8_t *to, uint64_t amount) {
+  int status;
+  HOST_INVOKE(host, status, erc20_transfer(to, amount));
+  (void)status;
+}
+
+static void qash_setup(host_t *host, size_t n) {
+  int status;
+  (void)n;
+  host_set_caller(host, _account(OWNER_ACCOUNT));
+  HOST_INVOKE(host, status, qash_init());
+  (void)status;
+  _qash_mint(host, _account(OWNER_ACCOUNT), 1ULL << 62);
+  for (size_t i = 0; i < WARM_ACCOUNTS; i++) {
+    _qash_mint(host, _warm(i), 1ULL << 40);
+    _qash_approve(host, _warm(i), 1);
+  }
+  _qash_approve(host, _account(SPENDER_ACCOUNT), 1ULL << 62);
+}
+
+static void qash_setup_funded(host_t *host, size_t n) {
+  qash_setup(host, n);
+  for (size_t i = 0; i < n; i++) {
+    _qash_mint(host, _cold(i), 1ULL << 20);
+  }
+}
+
+static int qash_transfer_warm(host_t *host, size_t i) {
+  int status;
+  host_set_caller(host, _account(OWNER_ACCOUNT));
+  HOST_INVOKE(host, status, qash_transfer(_warm(i), 1, 0));
+  return status;
+}
+
+static int qash_transfer_cold(host_t *host, size_t i) {
+  int status;
+  host_set_caller(host, _account(OWNER_ACCOUNT));
+  HOST_INVOKE(host, status, qash_transfer(_cold(i), 1, 0));
+  return status;
+}
+
+static int qash_transfer_from_warm(host_t *host, size_t i) {
+  int status;
+  host_set_caller(host, _account(SPENDER_ACCOUNT));
+  HOST_INVOKE(host, status, qash_transfer_from(_account(OWNER_ACCOUNT), _warm(i), 1, 0));
+  return status;
+}
+
+static int qash_transfer_from_cold(host_t *host, size_t i) {
+  int status;
+  host_set_caller(host, _account(SPENDER_ACCOUNT));
+  HOST_INVOKE(host, status, qash_transfer_from(_account(OWNER_ACCOUNT), _cold(i), 1, 0));
+  return status;
+}
+
+static int qash_approve_warm(host_t *host, size_t i) {
+  int status;
+  host_set_caller(host, _account(OWNER_ACCOUNT));
+  HOST_INVOKE(host, status, qash_approve(_warm(i), i));
+  return status;
+}
+
+static int qash_approve_cold(host_t *host, size_t i) {
+  int status;
+  host_set_caller(host, _account(OWNER_ACCOUNT));
+  HOST_INVOKE(host, status, qash_approve(_cold(i), i));
+  return status;
+}
+
+static int qash_mint_warm(host_t *host, size_t i) {
+  int status;
+  host_set_caller(host, _account(OWNER_ACCOUNT));
+  HOST_INVOKE(host, status, qash_mint(_warm(i), 1));
+  return status;
+}
+
+static int qash_mint_cold(host_t *host, size_t i) {
+  int status;
+  host_set_caller(host, _account(OWNER_ACCOUNT));
+  HOST_INVOKE(host, status, qash_mint(_cold(i), 1));
+  return status;
+}
+
+static int qash_burn_warm(host_t *host, size_t i) {
+  int status;
+  host_set_caller(host, _warm(i));
+  HOST_INVOKE(host, status, qash_burn(1));
+  return status;
+}
+
+static int qash_burn_cold(host_t *host, size_t i) {
+  int status;
+  host_set_caller(host, _cold(i));
+  HOST_INVOKE(host, status, qash_burn(1));
+  return status;
+}
+
+// Ownership moves back and forth between the owner and the spender
+static void qash_propose(host_t *host, size_t i) {
+  int status;
+  uint8_t *from = _account(i % 2 ? SPENDER_ACCOUNT : OWNER_ACCOUNT);
+  uint8_t *to = _account(i % 2 ? OWNER_ACCOUNT : SPENDER_ACCOUNT);
+  host_set_caller(host, from);
+  HOST_INVOKE(host, status, qash_propose_new_owner(to));
+  (void)status;
+}
+
+static int qash_claim_ownership_warm(host_t *host, size_t i) {
+  int status;
+  host_set_caller(host, _account(i % 2 ? OWNER_ACCOUNT : SPENDER_ACCOUNT));
+  HOST_INVOKE(host, status, qash_claim_ownership());
+  return status;
+}
+
+// token
+
+static void token_setup(host_t *host, size_t n) {
+  int status;
+  (void)n;
+  host_set_creator(host, _account(OWNER_ACCOUNT));
+  host_set_caller(host, _account(OWNER_ACCOUNT));
+  HOST_INVOKE(host, status, token_mint(1ULL << 62));
+  (void)status;
+  for (size_t i = 0; i < WARM_ACCOUNTS; i++) {
+    _token_transfer(host, _warm(i), 1);
+  }
+}
+
+static int token_transfer_with_memo_warm(host_t *host, size_t i) {
+  int status;
+  host_set_caller(host, _account(OWNER_ACCOUNT));
+  HOST_INVOKE(host, status, token_transfer_with_memo(_warm(i), 1, i));
+  return status;
+}
+
+static int token_transfer_with_memo_cold(host_t *host, size_t i) {
+  int status;
+  host_set_caller(host, _account(OWNER_ACCOUNT));
+  HOST_INVOKE(host, status, token_transfer_with_memo(_cold(i), 1, i));
+  return status;
+}
+
+// erc20
+
+static void erc20_setup(host_t *host, size_t n) {
+  int status;
+  (void)n;
+  host_set_creator(host, _account(OWNER_ACCOUNT));
+  host_set_caller(host, _account(OWNER_ACCOUNT));
+  HOST_INVOKE(host, status, erc20_mint(1U << 30));
+  (void)status;
+  for (size_t i = 0; i < WARM_ACCOUNTS; i++) {
+    _erc20_transfer(host, _warm(i), 1);
+  }
+}
+
+static int erc20_transfer_warm(host_t *host, size_t i) {
+  int status;
+  host_set_caller(host, _account(OWNER_ACCOUNT));
+  HOST_INVOKE(host, status, erc20_transfer(_warm(i), 1));
+  return status;
+}
+
+static int erc20_transfer_cold(host_t *host, size_t i) {
+  int status;
+  host_set_caller(host, _account(OWNER_ACCOUNT));
+  HOST_INVOKE(host, status, erc20_transfer(_cold(i), 1));
+  return status;
+}
+
+static int erc20_mint_warm(host_t *host, size_t i) {
+  int status;
+  (void)i;
+  host_set_caller(host, _account(OWNER_ACCOUNT));
+  HOST_INVOKE(host, status, erc20_mint(1));
+  return status;
+}
+
+static const bench_t benches[] = {
+  {"qash", "transfer", "warm", qash_setup, NULL, qash_transfer_warm},
+  {"qash", "transfer", "cold", qash_setup, NULL, qash_transfer_cold},
+  {"qash", "transfer_from", "warm", qash_setup, NULL, qash_transfer_from_warm},
+  {"qash", "transfer_from", "cold", qash_setup, NULL, qash_transfer_from_cold},
+  {"qash", "approve", "warm", qash_setup, NULL, qash_approve_warm},
+  {"qash", "approve", "cold", qash_setup, NULL, qash_approve_cold},
+  {"qash", "mint", "warm", qash_setup, NULL, qash_mint_warm},
+  {"qash", "mint", "cold", qash_setup, NULL, qash_mint_cold},
+  {"qash", "burn", "warm", qash_setup, NULL, qash_burn_warm},
+  {"qash", "burn", "cold", qash_setup_funded, NULL, qash_burn_cold},
+  {"qash", "claim_ownership", "warm", qash_setup, qash_propose, qash_claim_ownership_warm},
+  {"token", "transfer_with_memo", "warm", token_setup, NULL, token_transfer_with_memo_warm},
+  {"token", "transfer_with_memo", "cold", token_setup, NULL, token_transfer_with_memo_cold},
+  {"erc20", "transfer", "warm", erc20_setup, NULL, erc20_transfer_warm},
+  {"erc20", "transfer", "cold", erc20_setup, NULL, erc20_transfer_cold},
+  {"erc20", "mint", "warm", erc20_setup, NULL, erc20_mint_warm},
+};
+
+/**
+ * Run one benchmark and print its row
+ */
+static void _run(const bench_t *bench, size_t n) {
+  host_t *host = host_new();
+  bench->setup(host, n);
+  host_clear_events(host);
+  host_reset_stats(host);
+  static accounting_t accounting;
+  if (with_accounting) {
+    accounting_attach(&accounting, host);
+  }
+
+  size_t failed = 0;
+  uint64_t elapsed = 0;
+  host_stats_t total;
+  if (!bench->prepare) {
+    uint64_t start = _now_ns();
+    for (size_t i = 0; i < n; i++) {
+      failed += bench->op(host, i) != HOST_OK;
+    }
+    elapsed = _now_ns() - start;
+    total = *host_stats(host);
+  } else {
+    // Time each op on its own and keep prepare out of the counters
+    memset(&total, 0, sizeof(total));
+    for (size_t i = 0; i < n; i++) {
+      bench->prepare(host, i);
+      host_clear_events(host);
+      host_reset_stats(host);
+      uint64_t start = _now_ns();
+      failed += bench->op(host, i) != HOST_OK;
+      elapsed += _now_ns() - start;
+      const host_stats_t *stats = host_stats(host);
+      total.host_calls += stats->host_calls;
+      total.storage_bytes_read += stats->storage_bytes_read;
+      total.storage_bytes_written += stats->storage_bytes_written;
+    }
+  }
+
+  printf("%-6s %-19s %-5s %10.1f %9.2f %11.2f %8zu\n",
+         bench->contract, bench->entrypoint, bench->state,
+         (double)elapsed / n,
+         (double)total.host_calls / n,
+         (double)total.storage_bytes_written / n,
+         failed);
+  if (with_accounting) {
+    accounting_print(&accounting, stdout);
+  }
+  host_free(host);
+}
+
+int main(int argc, char **argv) {
+  int arg = 1;
+  if (argc > arg && strcmp(argv[arg], "-a") == 0) {
+    with_accounting = 1;
+    arg++;
+  }
+  size_t n = argc > arg ? strtoul(argv[arg], NULL, 10) : DEFAULT_ITERATIONS;
+  const char *filter = argc > arg + 1 ? argv[arg + 1] : NULL;
+  if (!n) {
+    fprintf(stderr, "usage: %s [-a] [iterations] [filter]\n", argv[0]);
+    return 1;
+  }
+  _build_accounts(n);
+
+  printf("%-6s %-19s %-5s %10s %9s %11s %8s\n",
+         "", "entrypoint", "state", "ns/op", "calls/op", "write B/op", "aborted");
+  for (size_t i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+    const bench_t *bench = &benches[i];
+    char name[64];
+    snprintf(name, sizeof(name), "%s/%s/%s", bench->contract, bench->entrypoint, bench->state);
+    if (filter && !strstr(name, filter)) {
+      continue;
+    }
+    _run(bench, n);
+  }
+  free(accounts);
+  return 0;
+}
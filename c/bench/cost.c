@@ -0,0 +1,80 @@
+//
+//  cost.c
+//  Per-entrypoint cost profile of the native builds under a workload
+//
+//  usage: cost [qash|token|erc20] [transactions] [seed]
+//
+//  Runs the workload with a meter attached, then get_balance for the first
+//  accounts, and prints instructions, host calls, storage bytes and gas per
+//  invocation under the default schedule of meter.h. Instructions are
+//  hardware counts of the native code, "0" where perf counters are not
+//  available; compare them between builds, not with wasm instructions.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+#include "abi.h"
+#include "meter.h"
+#include "workload.h"
+
+#define DEFAULT_TRANSACTIONS 100000
+#define BALANCE_QUERIES 1000
+
+int main(int argc, char **argv) {
+  workload_contract_t contract = WORKLOAD_QASH;
+  if (argc > 1) {
+    for (contract = 0; contract < WORKLOAD_CONTRACT_COUNT; contract++) {
+      if (strcmp(argv[1], workload_contract_name(contract)) == 0) {
+        break;
+      }
+    }
+  }
+  size_t n = argc > 2 ? strtoul(argv[2], NULL, 10) : DEFAULT_TRANSACTIONS;
+  if (contract == WORKLOAD_CONTRACT_COUNT || !n) {
+    fprintf(stderr, "usage: %s [qash|token|erc20] [transactions] [seed]\n", argv[0]);
+    return 1;
+  }
+
+  workload_config_t config;
+  workload_default_config(&config);
+  if (argc > 3) {
+    config.seed = strtoull(argv[3], NULL, 10);
+  }
+  workload_t *workload = workload_new(&config);
+  host_t *host = host_new();
+
+  meter_t meter;
+  meter_schedule_t schedule;
+  meter_default_schedule(&schedule);
+  int counted = meter_native_available();
+  meter_attach(&meter, host, &schedule, counted ? meter_native_counter : NULL, NULL);
+  workload_prepare(host, contract);
+
+  for (size_t i = 0; i < n; i++) {
+    workload_tx_t tx;
+    workload_next(workload, &tx);
+    workload_apply(host, contract, &tx);
+    if ((i & 0xffff) == 0) {
+      host_clear_events(host);
+    }
+  }
+
+  const abi_function_t *get_balance = abi_function(workload_abi(contract), "get_balance");
+  abi_args_t args;
+  memset(&args, 0, sizeof(args));
+  for (uint32_t i = 0; i < BALANCE_QUERIES && i < config.accounts; i++) {
+    workload_address(i, args.address[0]);
+    abi_query(host, get_balance, &args, NULL);
+  }
+  meter_detach(&meter, host);
+
+  printf("%s, %zu transactions, seed %llu%s\n", workload_contract_name(contract), n,
+         (unsigned long long)config.seed, counted ? "" : ", no instruction counter");
+  meter_print(&meter, stdout);
+
+  host_free(host);
+  workload_free(workload);
+  return 0;
+}
@@ -0,0 +1,110 @@
+//
+//  diff.c
+//  Run one workload through qash, token and erc20 and compare them
+//
+//  usage: diff [transactions] [seed]
+//
+//  The workload is restricted to what all three implement, transfers and
+//  mints, so every account must end with the same balance on each. Prints
+//  throughput, host calls, contract heap use and storage footprint per
+//  contract, relative to qash. Exit status is 1 if balances differ.
+//
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "host.h"
+#include "workload.h"
+
+#define DEFAULT_TRANSACTIONS 1000000
+#define MAX_REPORTED 10
+
+typedef struct {
+  host_t *host;
+  double ns;
+  size_t aborted;
+  host_stats_t stats;
+} run_t;
+
+static uint64_t _now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void _run(run_t *run, workload_contract_t contract, const workload_tx_t *txs, size_t n) {
+  run->host = host_new();
+  workload_prepare(run->host, contract);
+  host_reset_stats(run->host);
+  run->aborted = 0;
+  uint64_t start = _now_ns();
+  for (size_t i = 0; i < n; i++) {
+    run->aborted += workload_apply(run->host, contract, &txs[i]) != HOST_OK;
+    if ((i & 0xffff) == 0) {
+      host_clear_events(run->host);
+    }
+  }
+  run->ns = (double)(_now_ns() - start) / n;
+  run->stats = *host_stats(run->host);
+}
+
+int main(int argc, char **argv) {
+  size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_TRANSACTIONS;
+  if (!n) {
+    fprintf(stderr, "usage: %s [transactions] [seed]\n", argv[0]);
+    return 1;
+  }
+  workload_config_t config;
+  workload_default_config(&config);
+  if (argc > 2) {
+    config.seed = strtoull(argv[2], NULL, 10);
+  }
+  config.weights[WORKLOAD_TRANSFER_FROM] = 0;
+  config.weights[WORKLOAD_APPROVE] = 0;
+  config.weights[WORKLOAD_BURN] = 0;
+  workload_t *workload = workload_new(&config);
+  workload_tx_t *txs = malloc(n * sizeof(workload_tx_t));
+  for (size_t i = 0; i < n; i++) {
+    workload_next(workload, &txs[i]);
+  }
+
+  run_t runs[WORKLOAD_CONTRACT_COUNT];
+  for (int c = 0; c < WORKLOAD_CONTRACT_COUNT; c++) {
+    _run(&runs[c], (workload_contract_t)c, txs, n);
+  }
+
+  printf("%zu transactions, seed %llu\n", n, (unsigned long long)config.seed);
+  printf("%-8s %10s %8s %8s %10s %12s %12s %10s %12s\n", "contract", "ns/tx", "vs qash", "aborted",
+         "calls/tx", "allocs/tx", "heap B/tx", "keys", "storage B");
+  for (int c = 0; c < WORKLOAD_CONTRACT_COUNT; c++) {
+    const run_t *run = &runs[c];
+    printf("%-8s %10.1f %8.2f %8zu %10.2f %12.2f %12.2f %10zu %12zu\n",
+           workload_contract_name((workload_contract_t)c), run->ns, run->ns / runs[WORKLOAD_QASH].ns,
+           run->aborted, (double)run->stats.host_calls / n, (double)run->stats.allocations / n,
+           (double)run->stats.bytes_allocated / n, host_storage_count(run->host),
+           host_storage_bytes(run->host));
+  }
+
+  size_t diverged = 0;
+  for (uint32_t account = 0; account < config.accounts; account++) {
+    uint64_t expected = workload_balance(runs[WORKLOAD_QASH].host, WORKLOAD_QASH, account);
+    for (int c = WORKLOAD_QASH + 1; c < WORKLOAD_CONTRACT_COUNT; c++) {
+      uint64_t balance = workload_balance(runs[c].host, (workload_contract_t)c, account);
+      if (balance != expected && ++diverged <= MAX_REPORTED) {
+        printf("account %u: qash %llu, %s %llu\n", account, (unsigned long long)expected,
+               workload_contract_name((workload_contract_t)c), (unsigned long long)balance);
+      }
+    }
+  }
+  printf("balances: %s (%zu mismatches over %u accounts)\n", diverged ? "DIVERGED" : "agree",
+         diverged, config.accounts);
+
+  for (int c = 0; c < WORKLOAD_CONTRACT_COUNT; c++) {
+    host_free(runs[c].host);
+  }
+  free(txs);
+  workload_free(workload);
+  return diverged != 0;
+}
@@ -0,0 +1,186 @@
+//
+//  replay.c
+//  Record a workload into a trace, then replay it as fast as possible
+//
+//  usage: replay record <qash|token|erc20> <transactions> <trace> [seed]
+//         replay <trace>
+//
+//  Replay starts from empty storage and checks every invocation against
+//  its recorded status, storage diff and events. Exit status is 1 on any
+//  divergence.
+//
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "host.h"
+#include "abi.h"
+#include "trace.h"
+#include "accounting.h"
+#include "workload.h"
+
+// Divergent invocations printed in full
+#define MAX_REPORTED 10
+
+typedef struct {
+  char names[ACCOUNTING_MAX_PREFIXES][ACCOUNTING_NAME_SIZE];
+  size_t counts[ACCOUNTING_MAX_PREFIXES];
+  size_t count;
+} prefix_counts_t;
+
+static uint64_t _now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void _count_prefix(void *ctx, const uint8_t *key, size_t key_size) {
+  prefix_counts_t *prefixes = ctx;
+  char name[ACCOUNTING_NAME_SIZE];
+  accounting_prefix(key, key_size, name);
+  size_t i = 0;
+  while (i < prefixes->count && strcmp(prefixes->names[i], name) != 0) {
+    i++;
+  }
+  if (i == prefixes->count) {
+    if (prefixes->count == ACCOUNTING_MAX_PREFIXES) {
+      return;
+    }
+    strcpy(prefixes->names[prefixes->count++], name);
+  }
+  prefixes->counts[i]++;
+}
+
+static int _record(const char *contract_name, size_t n, const char *path, uint64_t seed) {
+  workload_contract_t contract = 0;
+  while (contract < WORKLOAD_CONTRACT_COUNT && strcmp(workload_contract_name(contract), contract_name) != 0) {
+    contract++;
+  }
+  if (contract == WORKLOAD_CONTRACT_COUNT) {
+    fprintf(stderr, "unknown contract %s\n", contract_name);
+    return 1;
+  }
+  workload_config_t config;
+  workload_default_config(&config);
+  config.seed = seed;
+  workload_t *workload = workload_new(&config);
+  host_t *host = host_new();
+
+  uint8_t owner[ADDRESS_SIZE];
+  workload_address(WORKLOAD_OWNER, owner);
+  host_set_creator(host, owner);
+  trace_writer_t *writer = trace_create(path, workload_abi(contract), owner);
+  if (!writer) {
+    fprintf(stderr, "cannot create %s\n", path);
+    return 1;
+  }
+  const abi_function_t *init = abi_function(workload_abi(contract), "init");
+  size_t invocations = 0;
+  if (init) {
+    trace_call(writer, host, init, owner, &(abi_args_t){0}, NULL);
+    invocations++;
+  }
+
+  for (size_t i = 0; i < n; i++) {
+    workload_tx_t tx;
+    workload_call_t calls[WORKLOAD_MAX_CALLS];
+    workload_next(workload, &tx);
+    size_t count = workload_calls(contract, &tx, calls);
+    for (size_t j = 0; j < count; j++) {
+      uint8_t caller[ADDRESS_SIZE];
+      workload_address(calls[j].caller, caller);
+      trace_call(writer, host, calls[j].function, caller, &calls[j].args, NULL);
+      invocations++;
+    }
+    host_clear_events(host);
+  }
+
+  int failed = trace_close(writer);
+  printf("%s: recorded %zu invocations of %s into %s\n",
+         failed ? "error" : "ok", invocations, contract_name, path);
+  host_free(host);
+  workload_free(workload);
+  return failed != 0;
+}
+
+static int _replay(const char *path) {
+  trace_t *trace = trace_load(path);
+  if (!trace) {
+    fprintf(stderr, "cannot load trace %s\n", path);
+    return 1;
+  }
+  host_t *host = host_new();
+  host_set_creator(host, trace_creator(trace));
+
+  // Decode everything first so only execution and checking are timed
+  size_t count = 0, capacity = 1024;
+  trace_record_t *records = malloc(capacity * sizeof(trace_record_t));
+  int more;
+  while ((more = trace_next(trace, &records[count])) == 1) {
+    if (++count == capacity) {
+      capacity *= 2;
+      records = realloc(records, capacity * sizeof(trace_record_t));
+    }
+  }
+  if (more < 0) {
+    fprintf(stderr, "%s: corrupt after %zu records\n", path, count);
+  }
+
+  size_t diverged = 0, status_diverged = 0, writes_diverged = 0, events_diverged = 0;
+  prefix_counts_t prefixes;
+  memset(&prefixes, 0, sizeof(prefixes));
+  uint64_t start = _now_ns();
+  for (size_t i = 0; i < count; i++) {
+    int result = trace_check(trace, host, &records[i]);
+    if (result) {
+      diverged++;
+      status_diverged += (result & TRACE_STATUS) != 0;
+      writes_diverged += (result & TRACE_WRITES) != 0;
+      events_diverged += (result & TRACE_EVENTS) != 0;
+      if (result & TRACE_WRITES) {
+        trace_diverged_keys(trace, &records[i], _count_prefix, &prefixes);
+      }
+      if (diverged <= MAX_REPORTED) {
+        printf("diverged at %zu: %s%s%s%s\n", i, records[i].function->name,
+               result & TRACE_STATUS ? " status" : "",
+               result & TRACE_WRITES ? " writes" : "",
+               result & TRACE_EVENTS ? " events" : "");
+      }
+    }
+    if ((i & 0xffff) == 0) {
+      host_clear_events(host);
+    }
+  }
+  uint64_t elapsed = _now_ns() - start;
+
+  printf("%s: %zu invocations of %s in %.3f s, %.0f calls/s (%.1f ns/call)\n",
+         path, count, trace_contract(trace)->name, elapsed / 1e9,
+         count * 1e9 / elapsed, (double)elapsed / (count ? count : 1));
+  printf("diverged: %zu (status %zu, writes %zu, events %zu)\n",
+         diverged, status_diverged, writes_diverged, events_diverged);
+  for (size_t i = 0; i < prefixes.count; i++) {
+    printf("  %-14s %zu keys%s\n", prefixes.names[i], prefixes.counts[i],
+           strcmp(prefixes.names[i], "BALANCES") == 0 || strcmp(prefixes.names[i], "TOTAL_SUPPLY") == 0
+             ? "  <- supply state diverged" : "");
+  }
+
+  free(records);
+  host_free(host);
+  trace_free(trace);
+  return diverged || more < 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc >= 5 && strcmp(argv[1], "record") == 0) {
+    uint64_t seed = argc > 5 ? strtoull(argv[5], NULL, 10) : 1;
+    return _record(argv[2], strtoul(argv[3], NULL, 10), argv[4], seed);
+  }
+  if (argc == 2) {
+    return _replay(argv[1]);
+  }
+  fprintf(stderr, "usage: %s record <qash|token|erc20> <transactions> <trace> [seed]\n"
+                  "       %s <trace>\n", argv[0], argv[0]);
+  return 1;
+}
@@ -0,0 +1,200 @@
+//
+//  wasm_bench.c
+//  Compare c/erc20/contract.wasm under wasm3 with the native build of
+//  c/erc20/contract.c, both against the host emulator
+//
+//  usage: wasm_bench [iterations] [contract.wasm]
+//
+//  If the module was instrumented with a gas counter, also prints its cost
+//  profile from metered instruction counts (see meter.h).
+//
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "host.h"
+#include "contracts.h"
+#include "meter.h"
+#include "wasm.h"
+
+#define DEFAULT_ITERATIONS 200000
+#define DEFAULT_WASM "c/erc20/contract.wasm"
+#define WARM_ACCOUNTS 64
+#define METERED_ITERATIONS 1000
+
+static uint8_t owner[ADDRESS_SIZE];
+static uint8_t accounts[WARM_ACCOUNTS][ADDRESS_SIZE];
+
+static wasm_module_t *module;
+static wasm_function_t *wasm_transfer;
+static wasm_function_t *wasm_mint;
+static wasm_function_t *wasm_get_balance;
+
+static uint64_t _now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Native
+
+static int native_transfer(host_t *host, size_t i) {
+  int status;
+  HOST_INVOKE(host, status, erc20_transfer(accounts[i % WARM_ACCOUNTS], 1));
+  return status;
+}
+
+static int native_mint(host_t *host, size_t i) {
+  int status;
+  (void)i;
+  HOST_INVOKE(host, status, erc20_mint(1));
+  return status;
+}
+
+static int native_get_balance(host_t *host, size_t i) {
+  int status;
+  HOST_INVOKE(host, status, erc20_get_balance(accounts[i % WARM_ACCOUNTS]));
+  return status;
+}
+
+// wasm
+
+static int wasm_transfer_op(host_t *host, size_t i) {
+  uint64_t args[2] = {wasm_address(module, 0, accounts[i % WARM_ACCOUNTS]), 1};
+  return wasm_invoke(module, host, wasm_transfer, 2, args, NULL);
+}
+
+static int wasm_mint_op(host_t *host, size_t i) {
+  uint64_t args[1] = {1};
+  (void)i;
+  return wasm_invoke(module, host, wasm_mint, 1, args, NULL);
+}
+
+static int wasm_get_balance_op(host_t *host, size_t i) {
+  uint64_t args[1] = {wasm_address(module, 0, accounts[i % WARM_ACCOUNTS])};
+  return wasm_invoke(module, host, wasm_get_balance, 1, args, NULL);
+}
+
+typedef int (*op_t)(host_t *host, size_t i);
+
+static void _setup(host_t *host, op_t transfer) {
+  host_set_creator(host, owner);
+  host_set_caller(host, owner);
+  host_storage_put(host, owner, ADDRESS_SIZE, &(uint64_t){1U << 30}, sizeof(uint64_t));
+  for (size_t i = 0; i < WARM_ACCOUNTS; i++) {
+    transfer(host, i);
+  }
+  host_clear_events(host);
+  host_reset_stats(host);
+}
+
+/**
+ * Time n ops and return ns per op, calls receives host calls per op
+ */
+static double _time(host_t *host, op_t op, size_t n, size_t *failed, double *calls) {
+  uint64_t host_calls = host_stats(host)->host_calls;
+  uint64_t start = _now_ns();
+  for (size_t i = 0; i < n; i++) {
+    *failed += op(host, i) != HOST_OK;
+  }
+  double ns = (double)(_now_ns() - start) / n;
+  *calls = (double)(host_stats(host)->host_calls - host_calls) / n;
+  return ns;
+}
+
+/**
+ * Count balances that differ between the two hosts
+ */
+static size_t _diverged(const host_t *native, const host_t *wasm) {
+  size_t diverged = 0;
+  for (size_t i = 0; i <= WARM_ACCOUNTS; i++) {
+    const uint8_t *account = i < WARM_ACCOUNTS ? accounts[i] : owner;
+    size_t native_size, wasm_size;
+    const void *a = host_storage_find(native, account, ADDRESS_SIZE, &native_size);
+    const void *b = host_storage_find(wasm, account, ADDRESS_SIZE, &wasm_size);
+    diverged += native_size != wasm_size || (native_size && memcmp(a, b, native_size) != 0);
+  }
+  return diverged;
+}
+
+int main(int argc, char **argv) {
+  size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_ITERATIONS;
+  const char *path = argc > 2 ? argv[2] : DEFAULT_WASM;
+  if (!n) {
+    fprintf(stderr, "usage: %s [iterations] [contract.wasm]\n", argv[0]);
+    return 1;
+  }
+  owner[0] = 88;
+  for (size_t i = 0; i < WARM_ACCOUNTS; i++) {
+    accounts[i][0] = 88;
+    accounts[i][1] = (uint8_t)(i + 1);
+  }
+
+  module = wasm_load(path);
+  if (!module) {
+    return 1;
+  }
+  wasm_transfer = wasm_function(module, "transfer");
+  wasm_mint = wasm_function(module, "mint");
+  wasm_get_balance = wasm_function(module, "get_balance");
+  if (!wasm_transfer || !wasm_mint || !wasm_get_balance) {
+    fprintf(stderr, "%s: missing transfer, mint or get_balance export\n", path);
+    wasm_free(module);
+    return 1;
+  }
+
+  host_t *native = host_new();
+  host_t *wasm = host_new();
+  _setup(native, native_transfer);
+  _setup(wasm, wasm_transfer_op);
+
+  static const struct {
+    const char *name;
+    op_t native;
+    op_t wasm;
+  } ops[] = {
+    {"transfer", native_transfer, wasm_transfer_op},
+    {"mint", native_mint, wasm_mint_op},
+    {"get_balance", native_get_balance, wasm_get_balance_op},
+  };
+  // Host calls per op show when the module was built from older source
+  // than the native contract, the factor then covers that difference too
+  printf("%-12s %12s %12s %8s %13s %11s %8s\n", "entrypoint", "native ns", "wasm ns", "factor",
+         "native calls", "wasm calls", "aborted");
+  for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+    size_t failed = 0;
+    double native_calls, wasm_calls;
+    double native_ns = _time(native, ops[i].native, n, &failed, &native_calls);
+    double wasm_ns = _time(wasm, ops[i].wasm, n, &failed, &wasm_calls);
+    printf("%-12s %12.1f %12.1f %8.2f %13.2f %11.2f %8zu\n", ops[i].name, native_ns, wasm_ns, wasm_ns / native_ns,
+           native_calls, wasm_calls, failed);
+  }
+
+  if (wasm_metered(module)) {
+    meter_t meter;
+    meter_schedule_t schedule;
+    meter_default_schedule(&schedule);
+    meter_attach(&meter, wasm, &schedule, wasm_instructions, module);
+    // Native runs the same calls so the balances still compare
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+      size_t failed = 0;
+      double calls;
+      _time(native, ops[i].native, METERED_ITERATIONS, &failed, &calls);
+      _time(wasm, ops[i].wasm, METERED_ITERATIONS, &failed, &calls);
+    }
+    meter_detach(&meter, wasm);
+    printf("\n");
+    meter_print(&meter, stdout);
+  }
+
+  size_t diverged = _diverged(native, wasm);
+  if (diverged) {
+    printf("%zu balances differ between native and wasm\n", diverged);
+  }
+  host_free(native);
+  host_free(wasm);
+  wasm_free(module);
+  return diverged != 0;
+}
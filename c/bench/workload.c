@@ -0,0 +1,462 @@
+#include "workload.h"
+#include "contracts.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Resamples before a sender without balance is funded with a mint instead
+#define MAX_RESAMPLES 8
+
+struct workload {
+  workload_config_t config;
+  uint64_t rng;
+  uint32_t first_holder;
+  uint32_t holders;
+  // Cumulative Zipf weights over holder ranks, last is 1
+  double *cdf;
+  uint64_t *balances;
+  uint32_t weight_total;
+  // Genesis mints left to emit
+  uint32_t genesis_next;
+  // Queued ops of a burst or sweep
+  workload_tx_t *queue;
+  size_t queue_head;
+  size_t queue_size;
+  size_t queue_capacity;
+};
+
+static const char *op_names[WORKLOAD_OP_COUNT] = {
+  "transfer",
+  "transfer_from",
+  "approve",
+  "mint",
+  "burn",
+};
+
+static const char *contract_names[WORKLOAD_CONTRACT_COUNT] = {
+  "qash",
+  "token",
+  "erc20",
+};
+
+/**
+ * splitmix64
+ */
+static uint64_t _next(workload_t *workload) {
+  uint64_t z = (workload->rng += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static double _uniform(workload_t *workload) {
+  return (_next(workload) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static uint64_t _below(workload_t *workload, uint64_t bound) {
+  return bound ? _next(workload) % bound : 0;
+}
+
+static uint32_t _holder(workload_t *workload) {
+  double u = _uniform(workload);
+  size_t lo = 0, hi = workload->holders - 1;
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (workload->cdf[mid] < u) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return workload->first_holder + (uint32_t)lo;
+}
+
+static uint32_t _hot(workload_t *workload) {
+  return 1 + (uint32_t)_below(workload, workload->config.hot_accounts);
+}
+
+static uint32_t _recipient(workload_t *workload, uint32_t sender) {
+  for (;;) {
+    uint32_t to = workload->config.hot_accounts && _uniform(workload) < workload->config.hot_share
+                    ? _hot(workload)
+                    : _holder(workload);
+    if (to != sender) {
+      return to;
+    }
+  }
+}
+
+/**
+ * Pick a funded sender, the last candidate if none of them is
+ */
+static uint32_t _sender(workload_t *workload) {
+  uint32_t sender = 0;
+  for (int i = 0; i < MAX_RESAMPLES; i++) {
+    sender = workload->config.hot_accounts && _uniform(workload) < workload->config.hot_share / 2
+               ? _hot(workload)
+               : _holder(workload);
+    if (workload->balances[sender]) {
+      break;
+    }
+  }
+  return sender;
+}
+
+static void _push(workload_t *workload, const workload_tx_t *tx) {
+  size_t tail = (workload->queue_head + workload->queue_size) % workload->queue_capacity;
+  workload->queue[tail] = *tx;
+  workload->queue_size++;
+}
+
+static void _mint(workload_t *workload, uint32_t to, uint64_t value, workload_tx_t *tx) {
+  memset(tx, 0, sizeof(workload_tx_t));
+  tx->op = WORKLOAD_MINT;
+  tx->caller = WORKLOAD_OWNER;
+  tx->to = to;
+  tx->value = value;
+  workload->balances[to] += value;
+}
+
+static void _transfer(workload_t *workload, workload_tx_t *tx) {
+  uint32_t from = _sender(workload);
+  if (!workload->balances[from]) {
+    _mint(workload, from, 1 + _below(workload, 1000), tx);
+    return;
+  }
+  memset(tx, 0, sizeof(workload_tx_t));
+  tx->op = WORKLOAD_TRANSFER;
+  tx->caller = from;
+  tx->from = from;
+  tx->to = _recipient(workload, from);
+  tx->value = 1 + _below(workload, workload->balances[from] / 8 + 1);
+  if (tx->value > workload->balances[from]) {
+    tx->value = workload->balances[from];
+  }
+  tx->memo = _next(workload);
+  workload->balances[from] -= tx->value;
+  workload->balances[tx->to] += tx->value;
+}
+
+/**
+ * A holder approves an exchange, which then pulls the amount in
+ */
+static void _sweep(workload_t *workload, workload_tx_t *tx) {
+  uint32_t holder = _holder(workload);
+  if (!workload->config.hot_accounts || !workload->balances[holder]) {
+    _transfer(workload, tx);
+    return;
+  }
+  uint32_t exchange = _hot(workload);
+  uint64_t value = 1 + _below(workload, workload->balances[holder]);
+  if (value > workload->balances[holder]) {
+    value = workload->balances[holder];
+  }
+  memset(tx, 0, sizeof(workload_tx_t));
+  tx->op = WORKLOAD_APPROVE;
+  tx->caller = holder;
+  tx->to = exchange;
+  tx->value = value;
+
+  workload_tx_t pull;
+  memset(&pull, 0, sizeof(pull));
+  pull.op = WORKLOAD_TRANSFER_FROM;
+  pull.caller = exchange;
+  pull.from = holder;
+  pull.to = exchange;
+  pull.value = value;
+  pull.memo = _next(workload);
+  _push(workload, &pull);
+  workload->balances[holder] -= value;
+  workload->balances[exchange] += value;
+}
+
+static void _approve(workload_t *workload, workload_tx_t *tx) {
+  memset(tx, 0, sizeof(workload_tx_t));
+  tx->op = WORKLOAD_APPROVE;
+  tx->caller = _holder(workload);
+  tx->to = _recipient(workload, tx->caller);
+  tx->value = _below(workload, 1000000);
+}
+
+static void _burn(workload_t *workload, workload_tx_t *tx) {
+  uint32_t caller = _holder(workload);
+  if (!workload->balances[caller]) {
+    _transfer(workload, tx);
+    return;
+  }
+  memset(tx, 0, sizeof(workload_tx_t));
+  tx->op = WORKLOAD_BURN;
+  tx->caller = caller;
+  tx->from = caller;
+  tx->value = 1 + _below(workload, workload->balances[caller] / 4);
+  workload->balances[caller] -= tx->value;
+}
+
+static void _fresh(workload_t *workload, workload_tx_t *tx) {
+  const workload_config_t *config = &workload->config;
+  uint32_t pick = (uint32_t)_below(workload, workload->weight_total);
+  workload_op_t op = 0;
+  while (pick >= config->weights[op]) {
+    pick -= config->weights[op];
+    op++;
+  }
+  switch (op) {
+    case WORKLOAD_TRANSFER_FROM:
+      _sweep(workload, tx);
+      break;
+    case WORKLOAD_APPROVE:
+      _approve(workload, tx);
+      break;
+    case WORKLOAD_MINT:
+    case WORKLOAD_BURN:
+      // First op of the burst now, the rest queued
+      for (uint32_t i = 0; i < (config->burst ? config->burst : 1); i++) {
+        workload_tx_t next;
+        if (op == WORKLOAD_MINT) {
+          _mint(workload, _holder(workload), 1 + _below(workload, 10000), &next);
+        } else {
+          _burn(workload, &next);
+        }
+        if (i == 0) {
+          *tx = next;
+        } else {
+          _push(workload, &next);
+        }
+      }
+      break;
+    default:
+      _transfer(workload, tx);
+      break;
+  }
+}
+
+void workload_default_config(workload_config_t *config) {
+  memset(config, 0, sizeof(workload_config_t));
+  config->seed = 1;
+  config->accounts = 10000;
+  config->zipf_s = 1.1;
+  config->hot_accounts = 4;
+  config->hot_share = 0.3;
+  config->weights[WORKLOAD_TRANSFER] = 85;
+  config->weights[WORKLOAD_TRANSFER_FROM] = 8;
+  config->weights[WORKLOAD_APPROVE] = 5;
+  config->weights[WORKLOAD_MINT] = 1;
+  config->weights[WORKLOAD_BURN] = 1;
+  config->burst = 8;
+  config->genesis_supply = 1000000000;
+}
+
+workload_t *workload_new(const workload_config_t *config) {
+  if (config->accounts < config->hot_accounts + 3) {
+    return NULL;
+  }
+  workload_t *workload = calloc(1, sizeof(workload_t));
+  workload->config = *config;
+  workload->rng = config->seed;
+  workload->first_holder = 1 + config->hot_accounts;
+  workload->holders = config->accounts - workload->first_holder;
+  workload->cdf = malloc(workload->holders * sizeof(double));
+  workload->balances = calloc(config->accounts, sizeof(uint64_t));
+  workload->queue_capacity = (config->burst > 2 ? config->burst : 2);
+  workload->queue = malloc(workload->queue_capacity * sizeof(workload_tx_t));
+
+  double sum = 0;
+  for (uint32_t i = 0; i < workload->holders; i++) {
+    sum += 1.0 / pow(i + 1, config->zipf_s);
+    workload->cdf[i] = sum;
+  }
+  for (uint32_t i = 0; i < workload->holders; i++) {
+    workload->cdf[i] /= sum;
+  }
+  workload->cdf[workload->holders - 1] = 1.0;
+
+  for (int i = 0; i < WORKLOAD_OP_COUNT; i++) {
+    workload->weight_total += config->weights[i];
+  }
+  if (!workload->weight_total) {
+    // Plain transfers when no mix is given
+    workload->config.weights[WORKLOAD_TRANSFER] = 1;
+    workload->weight_total = 1;
+  }
+  workload->genesis_next = config->genesis_supply ? 0 : workload->holders;
+  return workload;
+}
+
+void workload_free(workload_t *workload) {
+  if (!workload) {
+    return;
+  }
+  free(workload->cdf);
+  free(workload->balances);
+  free(workload->queue);
+  free(workload);
+}
+
+void workload_next(workload_t *workload, workload_tx_t *tx) {
+  if (workload->genesis_next < workload->holders) {
+    uint32_t rank = workload->genesis_next++;
+    double share = workload->cdf[rank] - (rank ? workload->cdf[rank - 1] : 0);
+    uint64_t value = (uint64_t)(share * workload->config.genesis_supply);
+    _mint(workload, workload->first_holder + rank, value ? value : 1, tx);
+    return;
+  }
+  if (workload->queue_size) {
+    *tx = workload->queue[workload->queue_head];
+    workload->queue_head = (workload->queue_head + 1) % workload->queue_capacity;
+    workload->queue_size--;
+    return;
+  }
+  _fresh(workload, tx);
+}
+
+void workload_address(uint32_t account, uint8_t address[ADDRESS_SIZE]) {
+  memset(address, 0, ADDRESS_SIZE);
+  address[0] = 88;
+  memcpy(address + 1, &account, sizeof(account));
+}
+
+const char *workload_op_name(workload_op_t op) {
+  return op < WORKLOAD_OP_COUNT ? op_names[op] : "unknown";
+}
+
+const char *workload_contract_name(workload_contract_t contract) {
+  return contract < WORKLOAD_CONTRACT_COUNT ? contract_names[contract] : "unknown";
+}
+
+const abi_contract_t *workload_abi(workload_contract_t contract) {
+  static const abi_contract_t *contracts[WORKLOAD_CONTRACT_COUNT] = {&abi_qash, &abi_token, &abi_erc20};
+  return contract < WORKLOAD_CONTRACT_COUNT ? contracts[contract] : NULL;
+}
+
+void workload_prepare(host_t *host, workload_contract_t contract) {
+  uint8_t owner[ADDRESS_SIZE];
+  workload_address(WORKLOAD_OWNER, owner);
+  host_set_creator(host, owner);
+  host_set_caller(host, owner);
+  if (contract == WORKLOAD_QASH) {
+    abi_invoke(host, abi_function(&abi_qash, "init"), NULL, NULL);
+  }
+}
+
+static workload_call_t *_call(workload_call_t *call, workload_contract_t contract, const char *name, uint32_t caller) {
+  // Resolved once per contract and name, a contract uses one name per op
+  static struct {
+    const char *name;
+    const abi_function_t *function;
+  } cache[WORKLOAD_CONTRACT_COUNT][WORKLOAD_OP_COUNT];
+  size_t i = 0;
+  while (i < WORKLOAD_OP_COUNT && cache[contract][i].name && strcmp(cache[contract][i].name, name) != 0) {
+    i++;
+  }
+  if (i == WORKLOAD_OP_COUNT) {
+    call->function = abi_function(workload_abi(contract), name);
+  } else {
+    if (!cache[contract][i].name) {
+      cache[contract][i].name = name;
+      cache[contract][i].function = abi_function(workload_abi(contract), name);
+    }
+    call->function = cache[contract][i].function;
+  }
+  memset(&call->args, 0, sizeof(call->args));
+  call->caller = caller;
+  return call;
+}
+
+size_t workload_calls(workload_contract_t contract, const workload_tx_t *tx, workload_call_t calls[WORKLOAD_MAX_CALLS]) {
+  workload_call_t *call;
+  if (contract == WORKLOAD_QASH) {
+    switch (tx->op) {
+      case WORKLOAD_TRANSFER:
+        call = _call(&calls[0], contract, "transfer", tx->caller);
+        workload_address(tx->to, call->args.address[0]);
+        call->args.value[1] = tx->value;
+        call->args.value[2] = tx->memo;
+        return 1;
+      case WORKLOAD_TRANSFER_FROM:
+        call = _call(&calls[0], contract, "transfer_from", tx->caller);
+        workload_address(tx->from, call->args.address[0]);
+        workload_address(tx->to, call->args.address[1]);
+        call->args.value[2] = tx->value;
+        call->args.value[3] = tx->memo;
+        return 1;
+      case WORKLOAD_APPROVE:
+        call = _call(&calls[0], contract, "approve", tx->caller);
+        workload_address(tx->to, call->args.address[0]);
+        call->args.value[1] = tx->value;
+        return 1;
+      case WORKLOAD_MINT:
+        call = _call(&calls[0], contract, "mint", tx->caller);
+        workload_address(tx->to, call->args.address[0]);
+        call->args.value[1] = tx->value;
+        return 1;
+      case WORKLOAD_BURN:
+        call = _call(&calls[0], contract, "burn", tx->caller);
+        call->args.value[0] = tx->value;
+        return 1;
+      default:
+        return 0;
+    }
+  }
+
+  // token and erc20
+  const char *transfer = contract == WORKLOAD_TOKEN ? "transfer_with_memo" : "transfer";
+  switch (tx->op) {
+    case WORKLOAD_TRANSFER:
+      call = _call(&calls[0], contract, transfer, tx->caller);
+      workload_address(tx->to, call->args.address[0]);
+      call->args.value[1] = tx->value;
+      call->args.value[2] = tx->memo;
+      return 1;
+    case WORKLOAD_MINT:
+      call = _call(&calls[0], contract, "mint", tx->caller);
+      call->args.value[0] = tx->value;
+      if (tx->to == WORKLOAD_OWNER) {
+        return 1;
+      }
+      call = _call(&calls[1], contract, transfer, tx->caller);
+      workload_address(tx->to, call->args.address[0]);
+      call->args.value[1] = tx->value;
+      call->args.value[2] = 0;
+      return 2;
+    default:
+      return 0;
+  }
+}
+
+int workload_apply(host_t *host, workload_contract_t contract, const workload_tx_t *tx) {
+  workload_call_t calls[WORKLOAD_MAX_CALLS];
+  size_t count = workload_calls(contract, tx, calls);
+  if (!count) {
+    return WORKLOAD_SKIPPED;
+  }
+  for (size_t i = 0; i < count; i++) {
+    uint8_t caller[ADDRESS_SIZE];
+    int64_t ret;
+    workload_address(calls[i].caller, caller);
+    host_set_caller(host, caller);
+    if (abi_invoke(host, calls[i].function, &calls[i].args, &ret) != HOST_OK || ret == -1) {
+      return HOST_ABORTED;
+    }
+  }
+  return HOST_OK;
+}
+
+uint64_t workload_balance(const host_t *host, workload_contract_t contract, uint32_t account) {
+  // qash builds its own key, in either layout; token and erc20 use the address
+  uint8_t key[QASH_BALANCE_KEY_SIZE];
+  size_t key_size = ADDRESS_SIZE;
+  workload_address(account, key);
+  if (contract == WORKLOAD_QASH) {
+    uint8_t address[ADDRESS_SIZE];
+    memcpy(address, key, ADDRESS_SIZE);
+    key_size = qash__build_balance_key(key, address);
+  }
+
+  size_t size;
+  const void *value = host_storage_find(host, key, key_size, &size);
+  uint64_t balance = 0;
+  if (value) {
+    memcpy(&balance, value, size < sizeof(balance) ? size : sizeof(balance));
+  }
+  return balance;
+}
@@ -0,0 +1,123 @@
+//
+//  workload.h
+//  Seeded, replayable transaction streams for the sample contracts
+//
+//  Accounts are numbered: 0 is the contract owner, 1..hot_accounts are
+//  exchange accounts, the rest are holders ranked by Zipf activity.
+//  The generator keeps its own ledger, so the stream depends only on the
+//  config and never on execution results.
+//
+
+#ifndef workload_h
+#define workload_h
+
+#include <stdint.h>
+#include "host.h"
+#include "abi.h"
+
+// workload_apply result for ops a contract has no entrypoint for
+#define WORKLOAD_SKIPPED 2
+
+#define WORKLOAD_OWNER 0
+// Contract calls a transaction maps onto at most
+#define WORKLOAD_MAX_CALLS 2
+
+typedef enum {
+  WORKLOAD_TRANSFER,
+  WORKLOAD_TRANSFER_FROM,
+  WORKLOAD_APPROVE,
+  WORKLOAD_MINT,
+  WORKLOAD_BURN,
+  WORKLOAD_OP_COUNT,
+} workload_op_t;
+
+typedef enum {
+  WORKLOAD_QASH,
+  WORKLOAD_TOKEN,
+  WORKLOAD_ERC20,
+  WORKLOAD_CONTRACT_COUNT,
+} workload_contract_t;
+
+// Accounts by number, transfer_from moves from `from` to `to` on behalf of
+// caller, approve lets `to` spend for caller
+typedef struct {
+  workload_op_t op;
+  uint32_t caller;
+  uint32_t from;
+  uint32_t to;
+  uint64_t value;
+  uint64_t memo;
+} workload_tx_t;
+
+typedef struct {
+  const abi_function_t *function;
+  uint32_t caller;
+  abi_args_t args;
+} workload_call_t;
+
+typedef struct {
+  uint64_t seed;
+  uint32_t accounts;
+  // Zipf exponent of holder activity and genesis balances
+  double zipf_s;
+  uint32_t hot_accounts;
+  // Share of transfers paying into an exchange, half as many pay out
+  double hot_share;
+  // Relative frequency of each op. TRANSFER_FROM is an allowance sweep
+  // (approve then transfer_from into an exchange), MINT and BURN come in
+  // bursts of `burst` ops
+  uint32_t weights[WORKLOAD_OP_COUNT];
+  uint32_t burst;
+  // Minted to holders by Zipf rank before anything else, 0 to skip
+  uint64_t genesis_supply;
+} workload_config_t;
+
+typedef struct workload workload_t;
+
+/**
+ * Defaults: 10000 accounts, s = 1.1, 4 exchanges taking 30% of transfers,
+ * mostly transfers with 8% sweeps and bursts of 8 mints or burns, a 1e9
+ * genesis supply (erc20 balances are 32 bits)
+ */
+void workload_default_config(workload_config_t *config);
+
+workload_t *workload_new(const workload_config_t *config);
+void workload_free(workload_t *workload);
+
+/**
+ * Produce the next transaction of the stream
+ */
+void workload_next(workload_t *workload, workload_tx_t *tx);
+
+void workload_address(uint32_t account, uint8_t address[ADDRESS_SIZE]);
+
+const char *workload_op_name(workload_op_t op);
+const char *workload_contract_name(workload_contract_t contract);
+
+const abi_contract_t *workload_abi(workload_contract_t contract);
+
+/**
+ * Make account 0 creator and owner of contract on host
+ */
+void workload_prepare(host_t *host, workload_contract_t contract);
+
+/**
+ * Contract calls tx maps onto, in order, 0 if contract cannot run it.
+ * token and erc20 mint to the owner, so a mint is followed by a transfer to
+ * the recipient; they have no allowances or burn.
+ */
+size_t workload_calls(workload_contract_t contract, const workload_tx_t *tx, workload_call_t calls[WORKLOAD_MAX_CALLS]);
+
+/**
+ * Run the calls of tx against contract on host, stopping at the first that
+ * fails. Return HOST_OK, HOST_ABORTED when the contract exits or returns -1,
+ * or WORKLOAD_SKIPPED.
+ */
+int workload_apply(host_t *host, workload_contract_t contract, const workload_tx_t *tx);
+
+/**
+ * Balance of account as stored by contract on host, read without imports
+ */
+uint64_t workload_balance(const host_t *host, workload_contract_t contract, uint32_t account);
+
+#endif /* workload_h */
@@ -0,0 +1,211 @@
+//
+//  workload_bench.c
+//  Run a seeded synthetic workload against one contract
+//
+//  usage: workload_bench [-p top] [-a] [qash|token|erc20] [transactions] [seed]
+//
+//  -p: profile storage accesses and print the prefixes and the top hottest
+//      keys (slows the run down, throughput is not comparable)
+//  -a: prefetch the access list of every transaction before running it, and
+//      count the keys the contract touched without declaring them
+//
+//  The stream and state digests only depend on the arguments, so two runs
+//  with the same arguments must print the same digests.
+//
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "host.h"
+#include "heatmap.h"
+#include "workload.h"
+
+#define DEFAULT_TRANSACTIONS 1000000
+
+static uint32_t hot_accounts;
+
+// Access lists of the transaction being run, for -a
+typedef struct {
+  uint8_t lists[WORKLOAD_MAX_CALLS][HOST_ACCESS_SIZE];
+  size_t sizes[WORKLOAD_MAX_CALLS];
+  size_t count;
+  uint64_t declared;
+  uint64_t undeclared;
+} access_check_t;
+
+static uint64_t _now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t _digest(uint64_t h, const void *data, size_t size) {
+  const uint8_t *p = data;
+  for (size_t i = 0; i < size; i++) {
+    h ^= p[i];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+/**
+ * Name workload accounts in heatmap keys
+ */
+static void _label(const uint8_t address[ADDRESS_SIZE], char label[HEATMAP_LABEL_SIZE]) {
+  uint32_t account;
+  memcpy(&account, address + 1, sizeof(account));
+  uint8_t expected[ADDRESS_SIZE];
+  workload_address(account, expected);
+  if (memcmp(address, expected, ADDRESS_SIZE) != 0) {
+    return;
+  }
+  if (account == WORKLOAD_OWNER) {
+    strcpy(label, "owner");
+  } else if (account <= hot_accounts) {
+    snprintf(label, HEATMAP_LABEL_SIZE, "exchange %u", account);
+  } else {
+    snprintf(label, HEATMAP_LABEL_SIZE, "holder %u", account);
+  }
+}
+
+static void _check(void *ctx, host_import_t import, const void *key, size_t key_size, size_t value_size) {
+  access_check_t *check = ctx;
+  (void)import;
+  (void)value_size;
+  // Batches report their keys through access
+  if (!key) {
+    return;
+  }
+  for (size_t i = 0; i < check->count; i++) {
+    const uint8_t *list = check->lists[i];
+    for (size_t offset = 0; offset < check->sizes[i]; offset += 1 + list[offset]) {
+      if (list[offset] == key_size && memcmp(list + offset + 1, key, key_size) == 0) {
+        return;
+      }
+    }
+  }
+  check->undeclared++;
+}
+
+/**
+ * Build and prefetch the access lists of tx
+ */
+static void _prefetch(access_check_t *check, host_t *host, workload_contract_t contract, const workload_tx_t *tx) {
+  workload_call_t calls[WORKLOAD_MAX_CALLS];
+  check->count = workload_calls(contract, tx, calls);
+  for (size_t i = 0; i < check->count; i++) {
+    uint8_t caller[ADDRESS_SIZE];
+    workload_address(calls[i].caller, caller);
+    check->sizes[i] = abi_access(calls[i].function, caller, &calls[i].args, check->lists[i]);
+    check->declared += host_prefetch(host, check->lists[i], check->sizes[i]);
+  }
+}
+
+int main(int argc, char **argv) {
+  int arg = 1;
+  size_t top = 0;
+  if (argc > arg + 1 && strcmp(argv[arg], "-p") == 0) {
+    top = strtoul(argv[arg + 1], NULL, 10);
+    arg += 2;
+  }
+  int prefetch = argc > arg && strcmp(argv[arg], "-a") == 0;
+  arg += prefetch;
+  workload_contract_t contract = WORKLOAD_QASH;
+  if (argc > arg) {
+    for (contract = 0; contract < WORKLOAD_CONTRACT_COUNT; contract++) {
+      if (strcmp(argv[arg], workload_contract_name(contract)) == 0) {
+        break;
+      }
+    }
+  }
+  size_t n = argc > arg + 1 ? strtoul(argv[arg + 1], NULL, 10) : DEFAULT_TRANSACTIONS;
+  if (contract == WORKLOAD_CONTRACT_COUNT || !n) {
+    fprintf(stderr, "usage: %s [-p top] [-a] [qash|token|erc20] [transactions] [seed]\n", argv[0]);
+    return 1;
+  }
+
+  workload_config_t config;
+  workload_default_config(&config);
+  if (argc > arg + 2) {
+    config.seed = strtoull(argv[arg + 2], NULL, 10);
+  }
+  hot_accounts = config.hot_accounts;
+  workload_t *workload = workload_new(&config);
+  host_t *host = host_new();
+  heatmap_t heatmap;
+  if (top) {
+    heatmap_attach(&heatmap, host);
+    heatmap.label = _label;
+  }
+  workload_prepare(host, contract);
+  static access_check_t check;
+  host_observer_t checker = {NULL, _check, _check, NULL, &check};
+  if (prefetch) {
+    host_add_observer(host, &checker);
+  }
+
+  // Generate up front so only execution is timed
+  workload_tx_t *txs = malloc(n * sizeof(workload_tx_t));
+  uint64_t stream_digest = 14695981039346656037ULL;
+  for (size_t i = 0; i < n; i++) {
+    workload_next(workload, &txs[i]);
+    stream_digest = _digest(stream_digest, &txs[i].op, sizeof(txs[i].op));
+    stream_digest = _digest(stream_digest, &txs[i].caller, 3 * sizeof(uint32_t) + 2 * sizeof(uint64_t));
+  }
+
+  size_t counts[WORKLOAD_OP_COUNT] = {0};
+  size_t aborted[WORKLOAD_OP_COUNT] = {0};
+  size_t skipped[WORKLOAD_OP_COUNT] = {0};
+  uint64_t start = _now_ns();
+  for (size_t i = 0; i < n; i++) {
+    if (prefetch) {
+      _prefetch(&check, host, contract, &txs[i]);
+    }
+    int status = workload_apply(host, contract, &txs[i]);
+    counts[txs[i].op]++;
+    aborted[txs[i].op] += status == HOST_ABORTED;
+    skipped[txs[i].op] += status == WORKLOAD_SKIPPED;
+    if ((i & 0xffff) == 0) {
+      host_clear_events(host);
+    }
+  }
+  uint64_t elapsed = _now_ns() - start;
+  if (top) {
+    heatmap_detach(&heatmap, host);
+  }
+  if (prefetch) {
+    host_remove_observer(host, &checker);
+  }
+
+  uint64_t state_digest = 14695981039346656037ULL;
+  for (uint32_t account = 0; account < config.accounts; account++) {
+    uint64_t balance = workload_balance(host, contract, account);
+    state_digest = _digest(state_digest, &balance, sizeof(balance));
+  }
+
+  printf("%s: %zu transactions, seed %llu\n", workload_contract_name(contract), n, (unsigned long long)config.seed);
+  printf("%-14s %10s %10s %10s\n", "op", "count", "aborted", "skipped");
+  for (int op = 0; op < WORKLOAD_OP_COUNT; op++) {
+    printf("%-14s %10zu %10zu %10zu\n", workload_op_name(op), counts[op], aborted[op], skipped[op]);
+  }
+  printf("throughput     %.0f tx/s (%.1f ns/tx)\n", n * 1e9 / elapsed, (double)elapsed / n);
+  printf("stream digest  %016llx\n", (unsigned long long)stream_digest);
+  printf("state digest   %016llx\n", (unsigned long long)state_digest);
+  if (prefetch) {
+    printf("access lists   %.2f keys/tx prefetched, %llu accesses undeclared\n", (double)check.declared / n,
+           (unsigned long long)check.undeclared);
+  }
+
+  if (top) {
+    printf("\n");
+    heatmap_print(&heatmap, top, stdout);
+    heatmap_free(&heatmap);
+  }
+
+  free(txs);
+  host_free(host);
+  workload_free(workload);
+  return 0;
+}
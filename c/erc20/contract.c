@@ -1,5 +1,6 @@
 #include <string.h>
 #include <vertex.h>
+#include "../sdk/sdk.h"
 
 extern Event Mint(address to, uint64_t amount);
 extern Event Transfer(address from, address to, uint64_t amount);
@@ -13,32 +14,8 @@ void sdk_storage_set(byte_t* key, size_t key_size, byte_t* value, size_t value_s
     chain_storage_set(key, key_size, value, value_size);
 }
 
-// sdk_storage_get
-byte_t* sdk_storage_get(byte_t* key, size_t key_size) {
-  int size = chain_storage_size_get(key, key_size);
-  if (size == 0) {
-      return 0;
-  }
-  byte_t* ret = (byte_t*) malloc(size * sizeof(byte_t));
-  chain_storage_get(key, key_size, ret);
-  return ret;
-}
-
-int from_bytes(uint8_t* bytes){
-  if (bytes==0) {
-    return 0;
-  }
-  return *(uint32_t*)bytes;
-}
-
 int sdk_caller_is_creator() {
-  address caller = (address) malloc(ADDR_SIZE * sizeof(byte_t));
-  address creator = (address) malloc(ADDR_SIZE * sizeof(byte_t));
-  chain_get_caller(caller);
-  chain_get_creator(creator);
-  int n = memcmp(creator, caller, ADDR_SIZE);
-  free(caller);
-  free(creator);
+  int n = memcmp(sdk_creator(), sdk_caller(), ADDR_SIZE);
   if (n == 0) {
     return 1;
   }
@@ -46,13 +23,11 @@ int sdk_caller_is_creator() {
 }
 
 int caller_is_owner() {
-  address caller = (address) malloc(ADDR_SIZE * sizeof(byte_t));
-  chain_get_caller(caller);
-  address owner = (address) malloc(ADDR_SIZE * sizeof(byte_t));
-  owner = sdk_storage_get((byte_t *)OWNER, sizeof(OWNER));
-  int n = memcmp(owner, caller, ADDR_SIZE);
-  free(caller);
-  free(owner);
+  address owner = sdk_owner(OWNER, sizeof(OWNER));
+  if (!owner) {
+    return 0;
+  }
+  int n = memcmp(owner, sdk_caller(), ADDR_SIZE);
   if (n == 0) {
     return 1;
   }
@@ -60,14 +35,16 @@ int caller_is_owner() {
 }
 
 int set_owner(address owner) {
+  sdk_context_begin();
   if (!caller_is_owner()) {
     return -1;
   }
-  sdk_storage_set((byte_t *)OWNER, sizeof(OWNER), owner, ADDR_SIZE);
+  sdk_set_owner(OWNER, sizeof(OWNER), owner);
   return 0;
 }
 
 int pause() {
+  sdk_context_begin();
   if (!caller_is_owner()) {
     return -1;
   }
@@ -77,6 +54,7 @@ int pause() {
 }
 
 int unpause() {
+  sdk_context_begin();
   if (!caller_is_owner()) {
     return -1;
   }
@@ -86,11 +64,11 @@ int unpause() {
 }
 
 int is_pausing() {
-  return from_bytes(sdk_storage_get((byte_t *)IS_PAUSE, sizeof(IS_PAUSE)));
+  return sdk_storage_get_u64(IS_PAUSE, sizeof(IS_PAUSE), 0) != 0;
 }
 
 int change_balance(address to, uint64_t amount, int sign){
-  uint64_t to_balance = from_bytes(sdk_storage_get(to, ADDR_SIZE));
+  uint64_t to_balance = sdk_storage_get_u64(to, ADDR_SIZE, 0);
   if (sign < 0) {
     if (to_balance < amount) {
       return -1;
@@ -104,22 +82,15 @@ int change_balance(address to, uint64_t amount, int sign){
 }
 
 int set_owner_to_creator() {
-  address creator = (address) malloc(ADDR_SIZE * sizeof(byte_t));
-  chain_get_creator(creator);
-  sdk_storage_set((byte_t *)OWNER, sizeof(OWNER), creator, ADDR_SIZE);
-  free(creator);
+  sdk_set_owner(OWNER, sizeof(OWNER), sdk_creator());
   return 0;
 }
 
 int mint(uint64_t amount) {
+  sdk_context_begin();
   // set up genesis owner
-  if (!caller_is_owner()) {
-    address owner = (address) malloc(ADDR_SIZE * sizeof(byte_t));
-    owner = sdk_storage_get((byte_t *)OWNER, sizeof(OWNER));
-    if (!owner) {
-      set_owner_to_creator();
-    }
-    free(owner);
+  if (!sdk_owner(OWNER, sizeof(OWNER))) {
+    set_owner_to_creator();
   }
 
   if (!caller_is_owner()) {
@@ -127,26 +98,24 @@ int mint(uint64_t amount) {
   }
 
   // minting
-  address caller = (address) malloc(ADDR_SIZE * sizeof(byte_t));
-  chain_get_caller(caller);
+  address caller = sdk_caller();
   int success = change_balance(caller, amount, 1);
   if (success != -1) {
     Mint(caller, amount);
   }
-  free(caller);
   return success;
 }
 
-int get_balance(address address){
-  return from_bytes(sdk_storage_get(address, ADDR_SIZE));
+uint64_t get_balance(address address){
+  return sdk_storage_get_u64(address, ADDR_SIZE, 0);
 }
 
 int transfer(address to, uint64_t amount){
+  sdk_context_begin();
   if (is_pausing()) {
     return -1;
   }
-  byte_t from[ADDR_SIZE];
-  chain_get_caller(from);
+  address from = sdk_caller();
   int success = change_balance(from, amount, -1);
   if (success != -1) {
     success = change_balance(to, amount, 1);
@@ -0,0 +1,171 @@
+#include "abi.h"
+#include <string.h>
+#include "contracts.h"
+
+#define A(i) (args->address[i])
+#define U(i) (args->value[i])
+
+// qash
+
+static int64_t qash_init_(abi_args_t *args) { (void)args; qash_init(); return 0; }
+static int64_t qash_get_owner_(abi_args_t *args) { (void)args; qash_get_owner(); return 0; }
+static int64_t qash_is_owner_(abi_args_t *args) { (void)args; return qash_is_owner(); }
+static int64_t qash_propose_new_owner_(abi_args_t *args) { qash_propose_new_owner(A(0)); return 0; }
+static int64_t qash_is_new_owner_(abi_args_t *args) { (void)args; return qash_is_new_owner(); }
+static int64_t qash_claim_ownership_(abi_args_t *args) { (void)args; qash_claim_ownership(); return 0; }
+static int64_t qash_get_balance_(abi_args_t *args) { return (int64_t)qash_get_balance(A(0)); }
+static int64_t qash_is_paused_(abi_args_t *args) { (void)args; return qash_is_paused(); }
+static int64_t qash_pause_(abi_args_t *args) { (void)args; qash_pause(); return 0; }
+static int64_t qash_unpause_(abi_args_t *args) { (void)args; qash_unpause(); return 0; }
+static int64_t qash_transfer_(abi_args_t *args) { qash_transfer(A(0), U(1), U(2)); return 0; }
+static int64_t qash_get_allowance_(abi_args_t *args) { return (int64_t)qash_get_allowance(A(0), A(1)); }
+static int64_t qash_approve_(abi_args_t *args) { qash_approve(A(0), U(1)); return 0; }
+static int64_t qash_transfer_from_(abi_args_t *args) { qash_transfer_from(A(0), A(1), U(2), U(3)); return 0; }
+static int64_t qash_get_decimals_(abi_args_t *args) { (void)args; return qash_get_decimals(); }
+static int64_t qash_get_symbol_(abi_args_t *args) { (void)args; return (int64_t)qash_get_symbol(); }
+static int64_t qash_get_total_supply_(abi_args_t *args) { (void)args; return (int64_t)qash_get_total_supply(); }
+static int64_t qash_mint_(abi_args_t *args) { qash_mint(A(0), U(1)); return 0; }
+static int64_t qash_burn_(abi_args_t *args) { qash_burn(U(0)); return 0; }
+
+// qash access lists
+
+static size_t qash_pause_access_(uint8_t *caller, abi_args_t *args, uint8_t *list) { (void)args; return qash_pause_access(caller, list); }
+static size_t qash_unpause_access_(uint8_t *caller, abi_args_t *args, uint8_t *list) { (void)args; return qash_unpause_access(caller, list); }
+static size_t qash_transfer_access_(uint8_t *caller, abi_args_t *args, uint8_t *list) { return qash_transfer_access(caller, A(0), U(1), U(2), list); }
+static size_t qash_approve_access_(uint8_t *caller, abi_args_t *args, uint8_t *list) { return qash_approve_access(caller, A(0), U(1), list); }
+static size_t qash_transfer_from_access_(uint8_t *caller, abi_args_t *args, uint8_t *list) { return qash_transfer_from_access(caller, A(0), A(1), U(2), U(3), list); }
+static size_t qash_mint_access_(uint8_t *caller, abi_args_t *args, uint8_t *list) { return qash_mint_access(caller, A(0), U(1), list); }
+static size_t qash_burn_access_(uint8_t *caller, abi_args_t *args, uint8_t *list) { return qash_burn_access(caller, U(0), list); }
+
+static const abi_function_t qash_functions[] = {
+  {"init", "qash_init", "", qash_init_, NULL},
+  {"get_owner", "qash_get_owner", "", qash_get_owner_, NULL},
+  {"is_owner", "qash_is_owner", "", qash_is_owner_, NULL},
+  {"propose_new_owner", "qash_propose_new_owner", "a", qash_propose_new_owner_, NULL},
+  {"is_new_owner", "qash_is_new_owner", "", qash_is_new_owner_, NULL},
+  {"claim_ownership", "qash_claim_ownership", "", qash_claim_ownership_, NULL},
+  {"get_balance", "qash_get_balance", "a", qash_get_balance_, NULL},
+  {"is_paused", "qash_is_paused", "", qash_is_paused_, NULL},
+  {"pause", "qash_pause", "", qash_pause_, qash_pause_access_},
+  {"unpause", "qash_unpause", "", qash_unpause_, qash_unpause_access_},
+  {"transfer", "qash_transfer", "auu", qash_transfer_, qash_transfer_access_},
+  {"get_allowance", "qash_get_allowance", "aa", qash_get_allowance_, NULL},
+  {"approve", "qash_approve", "au", qash_approve_, qash_approve_access_},
+  {"transfer_from", "qash_transfer_from", "aauu", qash_transfer_from_, qash_transfer_from_access_},
+  {"get_decimals", "qash_get_decimals", "", qash_get_decimals_, NULL},
+  {"get_symbol", "qash_get_symbol", "", qash_get_symbol_, NULL},
+  {"get_total_supply", "qash_get_total_supply", "", qash_get_total_supply_, NULL},
+  {"mint", "qash_mint", "au", qash_mint_, qash_mint_access_},
+  {"burn", "qash_burn", "u", qash_burn_, qash_burn_access_},
+};
+
+// token
+
+static int64_t token_set_owner_(abi_args_t *args) { return token_set_owner(A(0)); }
+static int64_t token_pause_(abi_args_t *args) { (void)args; return token_pause(); }
+static int64_t token_unpause_(abi_args_t *args) { (void)args; return token_unpause(); }
+static int64_t token_is_pausing_(abi_args_t *args) { (void)args; return token_is_pausing(); }
+static int64_t token_get_balance_(abi_args_t *args) { return (int64_t)token_get_balance(A(0)); }
+static int64_t token_mint_(abi_args_t *args) { return token_mint(U(0)); }
+static int64_t token_transfer_with_memo_(abi_args_t *args) { return token_transfer_with_memo(A(0), U(1), U(2)); }
+static int64_t token_transfer_(abi_args_t *args) { return token_transfer(A(0), U(1)); }
+
+static const abi_function_t token_functions[] = {
+  {"set_owner", "token_set_owner", "a", token_set_owner_, NULL},
+  {"pause", "token_pause", "", token_pause_, NULL},
+  {"unpause", "token_unpause", "", token_unpause_, NULL},
+  {"is_pausing", "token_is_pausing", "", token_is_pausing_, NULL},
+  {"get_balance", "token_get_balance", "a", token_get_balance_, NULL},
+  {"mint", "token_mint", "u", token_mint_, NULL},
+  {"transfer_with_memo", "token_transfer_with_memo", "auu", token_transfer_with_memo_, NULL},
+  {"transfer", "token_transfer", "au", token_transfer_, NULL},
+};
+
+// erc20
+
+static int64_t erc20_set_owner_(abi_args_t *args) { return erc20_set_owner(A(0)); }
+static int64_t erc20_pause_(abi_args_t *args) { (void)args; return erc20_pause(); }
+static int64_t erc20_unpause_(abi_args_t *args) { (void)args; return erc20_unpause(); }
+static int64_t erc20_is_pausing_(abi_args_t *args) { (void)args; return erc20_is_pausing(); }
+static int64_t erc20_mint_(abi_args_t *args) { return erc20_mint(U(0)); }
+static int64_t erc20_get_balance_(abi_args_t *args) { return erc20_get_balance(A(0)); }
+static int64_t erc20_transfer_(abi_args_t *args) { return erc20_transfer(A(0), U(1)); }
+
+static const abi_function_t erc20_functions[] = {
+  {"set_owner", "erc20_set_owner", "a", erc20_set_owner_, NULL},
+  {"pause", "erc20_pause", "", erc20_pause_, NULL},
+  {"unpause", "erc20_unpause", "", erc20_unpause_, NULL},
+  {"is_pausing", "erc20_is_pausing", "", erc20_is_pausing_, NULL},
+  {"mint", "erc20_mint", "u", erc20_mint_, NULL},
+  {"get_balance", "erc20_get_balance", "a", erc20_get_balance_, NULL},
+  {"transfer", "erc20_transfer", "au", erc20_transfer_, NULL},
+};
+
+#define COUNT(array) (sizeof(array) / sizeof(array[0]))
+
+const abi_contract_t abi_qash = {"qash", qash_functions, COUNT(qash_functions)};
+const abi_contract_t abi_token = {"token", token_functions, COUNT(token_functions)};
+const abi_contract_t abi_erc20 = {"erc20", erc20_functions, COUNT(erc20_functions)};
+
+const abi_contract_t *abi_contract(const char *name) {
+  static const abi_contract_t *contracts[] = {&abi_qash, &abi_token, &abi_erc20};
+  for (size_t i = 0; i < COUNT(contracts); i++) {
+    if (strcmp(contracts[i]->name, name) == 0) {
+      return contracts[i];
+    }
+  }
+  return NULL;
+}
+
+const abi_function_t *abi_function(const abi_contract_t *contract, const char *name) {
+  for (size_t i = 0; i < contract->function_count; i++) {
+    if (strcmp(contract->functions[i].name, name) == 0) {
+      return &contract->functions[i];
+    }
+  }
+  return NULL;
+}
+
+size_t abi_access(const abi_function_t *function, const uint8_t caller[ADDRESS_SIZE], abi_args_t *args,
+                  uint8_t list[HOST_ACCESS_SIZE]) {
+  if (!function->access) {
+    return 0;
+  }
+  uint8_t address[ADDRESS_SIZE];
+  memcpy(address, caller, ADDRESS_SIZE);
+  return function->access(address, args, list);
+}
+
+size_t abi_prefetch(const host_t *host, const abi_function_t *function, const uint8_t caller[ADDRESS_SIZE],
+                    abi_args_t *args) {
+  uint8_t list[HOST_ACCESS_SIZE];
+  size_t size = abi_access(function, caller, args, list);
+  return size ? host_prefetch(host, list, size) : 0;
+}
+
+static int _invoke(host_t *host, const abi_function_t *function, abi_args_t *args, int64_t *ret, int read_only) {
+  volatile int64_t result = 0;
+  int status;
+  // Same as HOST_INVOKE, but named after the function rather than this call
+  if (setjmp(*host_begin(host, function->symbol)) == 0) {
+    if (read_only) {
+      host_read_only(host);
+    }
+    result = function->invoke(args);
+    status = host_end(host, 0);
+  } else {
+    status = host_end(host, 1);
+  }
+  if (ret) {
+    *ret = result;
+  }
+  return status;
+}
+
+int abi_invoke(host_t *host, const abi_function_t *function, abi_args_t *args, int64_t *ret) {
+  return _invoke(host, function, args, ret, 0);
+}
+
+int abi_query(host_t *host, const abi_function_t *function, abi_args_t *args, int64_t *ret) {
+  return _invoke(host, function, args, ret, 1);
+}
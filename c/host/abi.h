@@ -0,0 +1,79 @@
+//
+//  abi.h
+//  Exported functions of the native contract builds, callable by name
+//
+
+#ifndef abi_h
+#define abi_h
+
+#include <stdint.h>
+#include "host.h"
+
+#define ABI_MAX_PARAMS 4
+
+// Parameter i is address[i] or value[i], as given by the function params
+typedef struct {
+  uint8_t address[ABI_MAX_PARAMS][ADDRESS_SIZE];
+  uint64_t value[ABI_MAX_PARAMS];
+} abi_args_t;
+
+typedef struct {
+  // Export name, as in contract-abi.json
+  const char *name;
+  // Native symbol, also what accounting sees as the entrypoint
+  const char *symbol;
+  // One character per parameter: 'a' address, 'u' uint64
+  const char *params;
+  int64_t (*invoke)(abi_args_t *args);
+  // Write the access list of a call by caller to list (HOST_ACCESS_SIZE
+  // bytes) and return its size, NULL if the function publishes none
+  size_t (*access)(uint8_t *caller, abi_args_t *args, uint8_t *list);
+} abi_function_t;
+
+typedef struct {
+  const char *name;
+  const abi_function_t *functions;
+  size_t function_count;
+} abi_contract_t;
+
+extern const abi_contract_t abi_qash;
+extern const abi_contract_t abi_token;
+extern const abi_contract_t abi_erc20;
+
+/**
+ * Contracts by name, NULL if unknown
+ */
+const abi_contract_t *abi_contract(const char *name);
+
+/**
+ * Function by export name, NULL if contract has none
+ */
+const abi_function_t *abi_function(const abi_contract_t *contract, const char *name);
+
+/**
+ * Write the access list of a call to function by caller to list and return
+ * its size, 0 if function publishes no list
+ */
+size_t abi_access(const abi_function_t *function, const uint8_t caller[ADDRESS_SIZE], abi_args_t *args,
+                  uint8_t list[HOST_ACCESS_SIZE]);
+
+/**
+ * Prefetch on host the access list of a call to function by caller. Return
+ * the number of keys, 0 if function publishes no list.
+ */
+size_t abi_prefetch(const host_t *host, const abi_function_t *function, const uint8_t caller[ADDRESS_SIZE],
+                    abi_args_t *args);
+
+/**
+ * Invoke function on host with the current caller. ret, if not NULL,
+ * receives the return value widened to int64. Return HOST_OK or HOST_ABORTED.
+ */
+int abi_invoke(host_t *host, const abi_function_t *function, abi_args_t *args, int64_t *ret);
+
+/**
+ * Invoke a view read-only, see host_read_only: it aborts if it writes or
+ * emits. What it returned through chain_set_return is in host_return_data.
+ */
+int abi_query(host_t *host, const abi_function_t *function, abi_args_t *args, int64_t *ret);
+
+#endif /* abi_h */
@@ -0,0 +1,148 @@
+#include "accounting.h"
+#include <string.h>
+
+/**
+ * Find or add the row called name, NULL when the table is full
+ */
+static accounting_row_t *_row(accounting_row_t *rows, size_t *count, size_t capacity, const char *name) {
+  for (size_t i = 0; i < *count; i++) {
+    if (strcmp(rows[i].name, name) == 0) {
+      return &rows[i];
+    }
+  }
+  if (*count == capacity) {
+    return NULL;
+  }
+  accounting_row_t *row = &rows[(*count)++];
+  memset(row, 0, sizeof(accounting_row_t));
+  strncpy(row->name, name, ACCOUNTING_NAME_SIZE - 1);
+  return row;
+}
+
+static void _count(accounting_row_t *row, host_import_t import, size_t key_size, size_t value_size) {
+  row->imports[import].crossings++;
+  row->imports[import].key_bytes += key_size;
+  row->imports[import].value_bytes += value_size;
+  row->total.crossings++;
+  row->total.key_bytes += key_size;
+  row->total.value_bytes += value_size;
+}
+
+static void _begin(void *ctx, const char *call) {
+  accounting_t *accounting = ctx;
+  if (call != accounting->last_call) {
+    // Entrypoint is the invoked function name, e.g. "qash_transfer"
+    char name[ACCOUNTING_NAME_SIZE];
+    size_t size = strcspn(call, "( ");
+    if (size >= ACCOUNTING_NAME_SIZE) {
+      size = ACCOUNTING_NAME_SIZE - 1;
+    }
+    memcpy(name, call, size);
+    name[size] = 0;
+    accounting->last_call = call;
+    accounting->last_row = _row(accounting->entrypoints, &accounting->entrypoint_count, ACCOUNTING_MAX_ENTRYPOINTS, name);
+  }
+  accounting->current = accounting->last_row;
+  if (accounting->current) {
+    accounting->current->invocations++;
+  }
+}
+
+static void _access(void *ctx, host_import_t import, const void *key, size_t key_size, size_t value_size) {
+  accounting_t *accounting = ctx;
+  char name[ACCOUNTING_NAME_SIZE];
+  accounting_prefix(key, key_size, name);
+  accounting_row_t *row = _row(accounting->prefixes, &accounting->prefix_count, ACCOUNTING_MAX_PREFIXES, name);
+  if (row) {
+    _count(row, import, key_size, value_size);
+  }
+}
+
+static void _import(void *ctx, host_import_t import, const void *key, size_t key_size, size_t value_size) {
+  accounting_t *accounting = ctx;
+  if (accounting->current) {
+    _count(accounting->current, import, key_size, value_size);
+  }
+  if (key) {
+    _access(ctx, import, key, key_size, value_size);
+  }
+}
+
+static void _end(void *ctx, int status) {
+  accounting_t *accounting = ctx;
+  (void)status;
+  accounting->current = NULL;
+}
+
+int accounting_attach(accounting_t *accounting, host_t *host) {
+  memset(accounting, 0, sizeof(accounting_t));
+  accounting->observer.begin = _begin;
+  accounting->observer.import = _import;
+  accounting->observer.access = _access;
+  accounting->observer.end = _end;
+  accounting->observer.ctx = accounting;
+  return host_add_observer(host, &accounting->observer);
+}
+
+void accounting_detach(accounting_t *accounting, host_t *host) {
+  host_remove_observer(host, &accounting->observer);
+}
+
+// Prefixes of the compact key tags, as qash assigns them with
+// QASH_COMPACT_KEYS, so both layouts share their rows
+static const char *const tag_prefixes[] = {NULL, "BALANCES", "ALLOWANCES"};
+
+void accounting_prefix(const void *key, size_t key_size, char name[ACCOUNTING_NAME_SIZE]) {
+  const uint8_t *bytes = key;
+  if (key_size == ADDRESS_SIZE) {
+    strcpy(name, "(address)");
+    return;
+  }
+  // Compact keys, a one-byte tag then 32-byte address payloads
+  if (key_size > 1 && bytes[0] < ' ' && (key_size - 1) % 32 == 0) {
+    if (bytes[0] < sizeof(tag_prefixes) / sizeof(tag_prefixes[0]) && tag_prefixes[bytes[0]]) {
+      strcpy(name, tag_prefixes[bytes[0]]);
+    } else {
+      snprintf(name, ACCOUNTING_NAME_SIZE, "(tag %u)", bytes[0]);
+    }
+    return;
+  }
+  size_t size = 0;
+  while (size < key_size && size < ACCOUNTING_NAME_SIZE - 1 &&
+         ((bytes[size] >= 'A' && bytes[size] <= 'Z') || bytes[size] == '_')) {
+    size++;
+  }
+  if (!size || size == key_size || bytes[size] != 0) {
+    strcpy(name, "(other)");
+    return;
+  }
+  memcpy(name, bytes, size);
+  name[size] = 0;
+}
+
+static void _print_row(const accounting_row_t *row, double per, FILE *out) {
+  fprintf(out, "  %-24s %12.2f %12.2f %12.2f\n", row->name,
+          row->total.crossings / per, row->total.key_bytes / per, row->total.value_bytes / per);
+  for (int i = 0; i < HOST_IMPORT_COUNT; i++) {
+    const accounting_counter_t *counter = &row->imports[i];
+    if (!counter->crossings) {
+      continue;
+    }
+    fprintf(out, "    %-22s %12.2f %12.2f %12.2f\n", host_import_name((host_import_t)i),
+            counter->crossings / per, counter->key_bytes / per, counter->value_bytes / per);
+  }
+}
+
+void accounting_print(const accounting_t *accounting, FILE *out) {
+  uint64_t invocations = 0;
+  fprintf(out, "  %-24s %12s %12s %12s\n", "entrypoint", "crossings", "key B", "value B");
+  for (size_t i = 0; i < accounting->entrypoint_count; i++) {
+    const accounting_row_t *row = &accounting->entrypoints[i];
+    invocations += row->invocations;
+    _print_row(row, row->invocations ? (double)row->invocations : 1.0, out);
+  }
+  fprintf(out, "  %-24s %12s %12s %12s\n", "prefix", "crossings", "key B", "value B");
+  for (size_t i = 0; i < accounting->prefix_count; i++) {
+    _print_row(&accounting->prefixes[i], invocations ? (double)invocations : 1.0, out);
+  }
+}
@@ -0,0 +1,63 @@
+//
+//  accounting.h
+//  Host-call accounting per entrypoint and per storage prefix
+//
+
+#ifndef accounting_h
+#define accounting_h
+
+#include <stdio.h>
+#include "host.h"
+
+#define ACCOUNTING_MAX_ENTRYPOINTS 64
+#define ACCOUNTING_MAX_PREFIXES 32
+#define ACCOUNTING_NAME_SIZE 32
+
+typedef struct {
+  uint64_t crossings;
+  uint64_t key_bytes;
+  uint64_t value_bytes;
+} accounting_counter_t;
+
+// Counters of every import, plus their sum
+typedef struct {
+  char name[ACCOUNTING_NAME_SIZE];
+  uint64_t invocations;
+  accounting_counter_t imports[HOST_IMPORT_COUNT];
+  accounting_counter_t total;
+} accounting_row_t;
+
+typedef struct {
+  host_observer_t observer;
+  accounting_row_t entrypoints[ACCOUNTING_MAX_ENTRYPOINTS];
+  size_t entrypoint_count;
+  accounting_row_t prefixes[ACCOUNTING_MAX_PREFIXES];
+  size_t prefix_count;
+  // Row of the running invocation
+  accounting_row_t *current;
+  // Last HOST_INVOKE expression seen and its row, avoids reparsing
+  const char *last_call;
+  accounting_row_t *last_row;
+} accounting_t;
+
+/**
+ * Reset accounting and attach it to host. Return -1 if host has no free
+ * observer slot.
+ */
+int accounting_attach(accounting_t *accounting, host_t *host);
+void accounting_detach(accounting_t *accounting, host_t *host);
+
+/**
+ * Name of the storage prefix a key is counted under: the leading upper case
+ * C string of the key ("BALANCES", "PAUSE", ...), "(address)" for raw
+ * address keys, "(other)" otherwise
+ */
+void accounting_prefix(const void *key, size_t key_size, char name[ACCOUNTING_NAME_SIZE]);
+
+/**
+ * Print both breakdowns averaged per invocation, prefixes over all invocations.
+ * Prefix rows count each key of a batched import as one crossing.
+ */
+void accounting_print(const accounting_t *accounting, FILE *out);
+
+#endif /* accounting_h */
@@ -0,0 +1,70 @@
+//
+//  contracts.h
+//  Entrypoints of the native contract builds (qash.c, token.c, erc20.c)
+//
+
+#ifndef contracts_h
+#define contracts_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef ADDRESS_SIZE
+#define ADDRESS_SIZE 35
+#endif
+
+// c/qash/contract.c
+void qash_init(void);
+void qash_get_owner(void);
+uint8_t qash_is_owner(void);
+void qash_propose_new_owner(uint8_t new_owner[ADDRESS_SIZE]);
+uint8_t qash_is_new_owner(void);
+void qash_claim_ownership(void);
+uint64_t qash_get_balance(uint8_t address[ADDRESS_SIZE]);
+uint8_t qash_is_paused(void);
+void qash_pause(void);
+void qash_unpause(void);
+void qash_transfer(uint8_t to[ADDRESS_SIZE], uint64_t value, uint64_t memo);
+uint64_t qash_get_allowance(uint8_t owner[ADDRESS_SIZE], uint8_t spender[ADDRESS_SIZE]);
+void qash_approve(uint8_t spender[ADDRESS_SIZE], uint64_t value);
+void qash_transfer_from(uint8_t from[ADDRESS_SIZE], uint8_t to[ADDRESS_SIZE], uint64_t value, uint64_t memo);
+uint8_t qash_get_decimals(void);
+uint64_t qash_get_symbol(void);
+uint64_t qash_get_total_supply(void);
+void qash_mint(uint8_t to[ADDRESS_SIZE], uint64_t value);
+void qash_burn(uint64_t value);
+// Key of the balance of address, in the layout qash was built with (at most
+// QASH_BALANCE_KEY_SIZE bytes), return its size
+#define QASH_BALANCE_KEY_SIZE 44
+size_t qash__build_balance_key(uint8_t *key, uint8_t address[ADDRESS_SIZE]);
+// Access lists, see SDK_ACCESS_SIZE in c/qash/chain.h
+size_t qash_pause_access(uint8_t caller[ADDRESS_SIZE], uint8_t *list);
+size_t qash_unpause_access(uint8_t caller[ADDRESS_SIZE], uint8_t *list);
+size_t qash_transfer_access(uint8_t caller[ADDRESS_SIZE], uint8_t to[ADDRESS_SIZE], uint64_t value, uint64_t memo,
+                            uint8_t *list);
+size_t qash_approve_access(uint8_t caller[ADDRESS_SIZE], uint8_t spender[ADDRESS_SIZE], uint64_t value, uint8_t *list);
+size_t qash_transfer_from_access(uint8_t caller[ADDRESS_SIZE], uint8_t from[ADDRESS_SIZE], uint8_t to[ADDRESS_SIZE],
+                                 uint64_t value, uint64_t memo, uint8_t *list);
+size_t qash_mint_access(uint8_t caller[ADDRESS_SIZE], uint8_t to[ADDRESS_SIZE], uint64_t value, uint8_t *list);
+size_t qash_burn_access(uint8_t caller[ADDRESS_SIZE], uint64_t value, uint8_t *list);
+
+// c/token/contract.c
+int token_set_owner(uint8_t owner[ADDRESS_SIZE]);
+int token_pause(void);
+int token_unpause(void);
+int token_is_pausing(void);
+uint64_t token_get_balance(uint8_t address[ADDRESS_SIZE]);
+int token_mint(uint64_t amount);
+int token_transfer_with_memo(uint8_t to[ADDRESS_SIZE], uint64_t amount, uint64_t memo);
+int token_transfer(uint8_t to[ADDRESS_SIZE], uint64_t amount);
+
+// c/erc20/contract.c
+int erc20_set_owner(uint8_t *owner);
+int erc20_pause(void);
+int erc20_unpause(void);
+int erc20_is_pausing(void);
+int erc20_mint(uint64_t amount);
+uint64_t erc20_get_balance(uint8_t *address);
+int erc20_transfer(uint8_t *to, uint64_t amount);
+
+#endif /* contracts_h */
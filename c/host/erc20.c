@@ -0,0 +1,49 @@
+//
+//  erc20.c
+//  Native build of c/erc20/contract.c for the host emulator
+//
+//  Every global of the contract gets an erc20_ prefix so the sample contracts
+//  can share one binary. Heap use goes through the host so it shows up in
+//  host_stats. Build with -Ic/host/include so the contract picks up
+//  the native <vertex.h>.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+
+#define malloc host_contract_malloc
+#define free host_contract_free
+
+#define ADDR_SIZE erc20_ADDR_SIZE
+#define OWNER erc20_OWNER
+#define IS_PAUSE erc20_IS_PAUSE
+#define sdk_storage_set erc20_sdk_storage_set
+#define sdk_caller_is_creator erc20_sdk_caller_is_creator
+#define caller_is_owner erc20_caller_is_owner
+#define set_owner erc20_set_owner
+#define pause erc20_pause
+#define unpause erc20_unpause
+#define is_pausing erc20_is_pausing
+#define change_balance erc20_change_balance
+#define set_owner_to_creator erc20_set_owner_to_creator
+#define mint erc20_mint
+#define get_balance erc20_get_balance
+#define transfer erc20_transfer
+
+#define Mint erc20_Mint
+#define Transfer erc20_Transfer
+
+#include "../erc20/contract.c"
+
+// Events
+
+Event Mint(address to, uint64_t amount) {
+  host_emit(HOST_EVENT_MINT, to, NULL, amount, 0);
+  return 0;
+}
+
+Event Transfer(address from, address to, uint64_t amount) {
+  host_emit(HOST_EVENT_TRANSFER, from, to, amount, 0);
+  return 0;
+}
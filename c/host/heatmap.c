@@ -0,0 +1,227 @@
+#include "heatmap.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void *_grow(void *data, size_t *capacity, size_t needed, size_t item_size) {
+  if (needed <= *capacity) {
+    return data;
+  }
+  while (*capacity < needed) {
+    *capacity = *capacity ? *capacity * 2 : 1024;
+  }
+  data = realloc(data, *capacity * item_size);
+  if (!data) {
+    fprintf(stderr, "heatmap: out of memory\n");
+    abort();
+  }
+  return data;
+}
+
+static uint32_t _hash(const uint8_t *key, size_t size) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ key[i]) * 16777619u;
+  }
+  return hash;
+}
+
+static void _rehash(heatmap_t *heatmap) {
+  free(heatmap->slots);
+  heatmap->slot_count = heatmap->slot_count ? heatmap->slot_count * 2 : 4096;
+  heatmap->slots = calloc(heatmap->slot_count, sizeof(uint32_t));
+  for (size_t i = 0; i < heatmap->key_count; i++) {
+    const heatmap_key_t *entry = &heatmap->keys[i];
+    size_t slot = _hash(heatmap->arena + entry->offset, entry->size) & (heatmap->slot_count - 1);
+    while (heatmap->slots[slot]) {
+      slot = (slot + 1) & (heatmap->slot_count - 1);
+    }
+    heatmap->slots[slot] = (uint32_t)(i + 1);
+  }
+}
+
+static heatmap_prefix_t *_prefix(heatmap_t *heatmap, const void *key, size_t key_size) {
+  char name[ACCOUNTING_NAME_SIZE];
+  accounting_prefix(key, key_size, name);
+  for (size_t i = 0; i < heatmap->prefix_count; i++) {
+    if (strcmp(heatmap->prefixes[i].name, name) == 0) {
+      return &heatmap->prefixes[i];
+    }
+  }
+  if (heatmap->prefix_count == HEATMAP_MAX_PREFIXES) {
+    return NULL;
+  }
+  heatmap_prefix_t *prefix = &heatmap->prefixes[heatmap->prefix_count++];
+  memset(prefix, 0, sizeof(heatmap_prefix_t));
+  strcpy(prefix->name, name);
+  return prefix;
+}
+
+static heatmap_key_t *_key(heatmap_t *heatmap, const uint8_t *key, size_t key_size, int *added) {
+  size_t mask = heatmap->slot_count - 1;
+  size_t slot = _hash(key, key_size) & mask;
+  *added = 0;
+  while (heatmap->slots[slot]) {
+    heatmap_key_t *entry = &heatmap->keys[heatmap->slots[slot] - 1];
+    if (entry->size == key_size && memcmp(heatmap->arena + entry->offset, key, key_size) == 0) {
+      return entry;
+    }
+    slot = (slot + 1) & mask;
+  }
+  heatmap->keys = _grow(heatmap->keys, &heatmap->key_capacity, heatmap->key_count + 1, sizeof(heatmap_key_t));
+  heatmap->arena = _grow(heatmap->arena, &heatmap->arena_capacity, heatmap->arena_size + key_size, 1);
+  heatmap_key_t *entry = &heatmap->keys[heatmap->key_count++];
+  entry->offset = heatmap->arena_size;
+  entry->size = key_size;
+  entry->reads = 0;
+  entry->writes = 0;
+  entry->deltas = 0;
+  memcpy(heatmap->arena + heatmap->arena_size, key, key_size);
+  heatmap->arena_size += key_size;
+  heatmap->slots[slot] = (uint32_t)heatmap->key_count;
+  *added = 1;
+  // Keep the load factor under 1/2
+  if (heatmap->key_count * 2 > heatmap->slot_count) {
+    _rehash(heatmap);
+    entry = &heatmap->keys[heatmap->key_count - 1];
+  }
+  return entry;
+}
+
+static void _import(void *ctx, host_import_t import, const void *key, size_t key_size, size_t value_size) {
+  heatmap_t *heatmap = ctx;
+  uint64_t *key_count, *prefix_count, *total;
+  (void)value_size;
+  if (!key) {
+    return;
+  }
+  int added;
+  heatmap_key_t *entry;
+  heatmap_prefix_t *prefix;
+  switch (import) {
+    case HOST_IMPORT_STORAGE_SIZE_GET:
+    case HOST_IMPORT_STORAGE_GET:
+    case HOST_IMPORT_STORAGE_READ:
+    case HOST_IMPORT_STORAGE_GET_MANY:
+    case HOST_IMPORT_STORAGE_VIEW:
+      entry = _key(heatmap, key, key_size, &added);
+      prefix = _prefix(heatmap, key, key_size);
+      key_count = &entry->reads;
+      prefix_count = prefix ? &prefix->reads : NULL;
+      total = &heatmap->reads;
+      break;
+    case HOST_IMPORT_STORAGE_SET:
+    case HOST_IMPORT_STORAGE_SET_MANY:
+      entry = _key(heatmap, key, key_size, &added);
+      prefix = _prefix(heatmap, key, key_size);
+      key_count = &entry->writes;
+      prefix_count = prefix ? &prefix->writes : NULL;
+      total = &heatmap->writes;
+      break;
+    case HOST_IMPORT_STORAGE_DELTA_U64:
+      entry = _key(heatmap, key, key_size, &added);
+      prefix = _prefix(heatmap, key, key_size);
+      key_count = &entry->deltas;
+      prefix_count = prefix ? &prefix->deltas : NULL;
+      total = &heatmap->deltas;
+      break;
+    default:
+      return;
+  }
+  (*key_count)++;
+  (*total)++;
+  if (prefix) {
+    (*prefix_count)++;
+    prefix->keys += added;
+  }
+}
+
+int heatmap_attach(heatmap_t *heatmap, host_t *host) {
+  memset(heatmap, 0, sizeof(heatmap_t));
+  _rehash(heatmap);
+  heatmap->observer.import = _import;
+  heatmap->observer.access = _import;
+  heatmap->observer.ctx = heatmap;
+  return host_add_observer(host, &heatmap->observer);
+}
+
+void heatmap_detach(heatmap_t *heatmap, host_t *host) {
+  host_remove_observer(host, &heatmap->observer);
+}
+
+void heatmap_free(heatmap_t *heatmap) {
+  free(heatmap->keys);
+  free(heatmap->slots);
+  free(heatmap->arena);
+  memset(heatmap, 0, sizeof(heatmap_t));
+}
+
+static void _address(const heatmap_t *heatmap, const uint8_t *address, char *out, size_t size) {
+  char label[HEATMAP_LABEL_SIZE] = "";
+  if (heatmap->label) {
+    heatmap->label(address, label);
+  }
+  if (label[0]) {
+    snprintf(out, size, "%s", label);
+  } else {
+    snprintf(out, size, "%02x%02x%02x%02x%02x..", address[0], address[1], address[2], address[3], address[4]);
+  }
+}
+
+/**
+ * Prefix name followed by the addresses that make up the rest of the key
+ */
+static void _describe(const heatmap_t *heatmap, const uint8_t *key, size_t size, char *out, size_t out_size) {
+  char name[ACCOUNTING_NAME_SIZE];
+  size_t used = 0;
+  accounting_prefix(key, size, name);
+  if (size == ADDRESS_SIZE) {
+    _address(heatmap, key, out, out_size);
+    return;
+  }
+  used = snprintf(out, out_size, "%s", name);
+  size_t rest = name[0] != '(' ? strlen(name) + 1 : size;
+  while (rest + ADDRESS_SIZE <= size && used < out_size) {
+    char address[HEATMAP_LABEL_SIZE];
+    _address(heatmap, key + rest, address, sizeof(address));
+    used += snprintf(out + used, out_size - used, " %s", address);
+    rest += ADDRESS_SIZE;
+  }
+}
+
+static int _hotter(const void *a, const void *b) {
+  const heatmap_key_t *x = a, *y = b;
+  uint64_t hx = x->reads + x->writes + x->deltas, hy = y->reads + y->writes + y->deltas;
+  return hx < hy ? 1 : hx > hy ? -1 : 0;
+}
+
+static double _share(uint64_t part, uint64_t total) {
+  return total ? 100.0 * part / total : 0;
+}
+
+void heatmap_print(const heatmap_t *heatmap, size_t top, FILE *out) {
+  fprintf(out, "%-40s %12s %12s %12s %10s %8s %8s\n", "prefix", "reads", "writes", "deltas", "keys", "write %",
+          "delta %");
+  for (size_t i = 0; i < heatmap->prefix_count; i++) {
+    const heatmap_prefix_t *prefix = &heatmap->prefixes[i];
+    fprintf(out, "%-40s %12llu %12llu %12llu %10llu %8.2f %8.2f\n", prefix->name, (unsigned long long)prefix->reads,
+            (unsigned long long)prefix->writes, (unsigned long long)prefix->deltas,
+            (unsigned long long)prefix->keys, _share(prefix->writes, heatmap->writes),
+            _share(prefix->deltas, heatmap->deltas));
+  }
+
+  heatmap_key_t *sorted = malloc((heatmap->key_count ? heatmap->key_count : 1) * sizeof(heatmap_key_t));
+  memcpy(sorted, heatmap->keys, heatmap->key_count * sizeof(heatmap_key_t));
+  qsort(sorted, heatmap->key_count, sizeof(heatmap_key_t), _hotter);
+  fprintf(out, "%-40s %12s %12s %12s %10s %8s %8s\n", "key", "reads", "writes", "deltas", "", "write %", "delta %");
+  for (size_t i = 0; i < top && i < heatmap->key_count; i++) {
+    char description[64];
+    _describe(heatmap, heatmap->arena + sorted[i].offset, sorted[i].size, description, sizeof(description));
+    fprintf(out, "%-40s %12llu %12llu %12llu %10s %8.2f %8.2f\n", description, (unsigned long long)sorted[i].reads,
+            (unsigned long long)sorted[i].writes, (unsigned long long)sorted[i].deltas, "",
+            _share(sorted[i].writes, heatmap->writes), _share(sorted[i].deltas, heatmap->deltas));
+  }
+  fprintf(out, "%zu keys, %llu reads, %llu writes, %llu deltas\n", heatmap->key_count,
+          (unsigned long long)heatmap->reads, (unsigned long long)heatmap->writes,
+          (unsigned long long)heatmap->deltas);
+  free(sorted);
+}
@@ -0,0 +1,76 @@
+//
+//  heatmap.h
+//  Storage access profile: reads and writes per key prefix and per key
+//
+//  Keys that many transactions write are what serialises parallel
+//  execution, so the report ranks keys by accesses and shows each key's
+//  share of all writes. Checked deltas (chain_storage_delta_u64) commute
+//  and are counted apart from writes, with their own share of all deltas,
+//  so keys updated only through deltas still rank as hot.
+//
+
+#ifndef heatmap_h
+#define heatmap_h
+
+#include <stdio.h>
+#include "host.h"
+#include "accounting.h"
+
+#define HEATMAP_MAX_PREFIXES 32
+#define HEATMAP_LABEL_SIZE 24
+
+typedef struct {
+  // Offset of the key in the key arena
+  size_t offset;
+  size_t size;
+  uint64_t reads;
+  uint64_t writes;
+  // Checked u64 deltas, which commute with each other unlike writes
+  uint64_t deltas;
+} heatmap_key_t;
+
+typedef struct {
+  char name[ACCOUNTING_NAME_SIZE];
+  uint64_t reads;
+  uint64_t writes;
+  uint64_t deltas;
+  uint64_t keys;
+} heatmap_prefix_t;
+
+typedef struct {
+  host_observer_t observer;
+  heatmap_key_t *keys;
+  size_t key_count;
+  size_t key_capacity;
+  // Open addressing over keys, index + 1, 0 is empty
+  uint32_t *slots;
+  size_t slot_count;
+  uint8_t *arena;
+  size_t arena_size;
+  size_t arena_capacity;
+  heatmap_prefix_t prefixes[HEATMAP_MAX_PREFIXES];
+  size_t prefix_count;
+  uint64_t reads;
+  uint64_t writes;
+  uint64_t deltas;
+  // Optional name of an address in printed keys, e.g. "exchange 2"
+  void (*label)(const uint8_t address[ADDRESS_SIZE], char label[HEATMAP_LABEL_SIZE]);
+} heatmap_t;
+
+/**
+ * Start profiling host. Return -1 if host has no free observer slot.
+ */
+int heatmap_attach(heatmap_t *heatmap, host_t *host);
+
+/**
+ * Stop profiling, the counts stay until heatmap_free
+ */
+void heatmap_detach(heatmap_t *heatmap, host_t *host);
+void heatmap_free(heatmap_t *heatmap);
+
+/**
+ * Print the prefixes, then the top hottest keys by accesses
+ */
+void heatmap_print(const heatmap_t *heatmap, size_t top, FILE *out);
+
+#endif /* heatmap_h */
@@ -0,0 +1,922 @@
+#include "host.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_SLOTS 1024
+#define INITIAL_ACCOUNT_SLOTS 1024
+
+// Balance keys, "BALANCES\0" then the address, are found by account ID
+#define BALANCES_PREFIX "BALANCES"
+#define BALANCES_KEY_SIZE (sizeof(BALANCES_PREFIX) + ADDRESS_SIZE)
+
+typedef struct {
+  uint64_t hash;
+  uint8_t *key;
+  size_t key_size;
+  uint8_t *value;
+  size_t value_size;
+  size_t value_capacity;
+  // Held by the balances of an account rather than in the slots
+  int account;
+} entry_t;
+
+// Previous value of an entry written during the current invocation
+typedef struct {
+  size_t entry;
+  size_t offset;
+  size_t size;
+} undo_t;
+
+struct host {
+  // Entries are append only so their index is stable across rehashing
+  entry_t *entries;
+  size_t entry_count;
+  size_t entry_capacity;
+  // Open addressing index, 0 is empty, otherwise entry index + 1
+  uint32_t *slots;
+  size_t slot_count;
+  size_t slot_entry_count;
+
+  // Interned addresses, account ID i is addresses[i]. balances[i] is the
+  // entry index + 1 of its balance key, 0 if it has none.
+  uint8_t (*addresses)[ADDRESS_SIZE];
+  uint32_t *balances;
+  size_t account_count;
+  size_t account_capacity;
+  // Open addressing index of the addresses, 0 is empty, otherwise ID + 1
+  uint32_t *account_slots;
+  size_t account_slot_count;
+
+  uint8_t caller[ADDRESS_SIZE];
+  uint8_t creator[ADDRESS_SIZE];
+
+  host_stats_t stats;
+  const host_observer_t *observers[HOST_MAX_OBSERVERS];
+  size_t observer_count;
+
+  host_event_t *events;
+  size_t event_count;
+  size_t event_capacity;
+
+  // Invocation state
+  int in_call;
+  int read_only;
+  int refused;
+  uint8_t *return_data;
+  size_t return_size;
+  size_t return_capacity;
+  jmp_buf abort_point;
+  size_t call_event_count;
+  undo_t *undo;
+  size_t undo_count;
+  size_t undo_capacity;
+  uint8_t *undo_bytes;
+  size_t undo_bytes_size;
+  size_t undo_bytes_capacity;
+};
+
+static host_t *selected;
+
+static const char *import_names[HOST_IMPORT_COUNT] = {
+  "chain_storage_size_get",
+  "chain_storage_get",
+  "chain_storage_set",
+  "chain_get_caller",
+  "chain_get_creator",
+  "chain_storage_read",
+  "chain_storage_get_many",
+  "chain_storage_set_many",
+  "chain_storage_delta_u64",
+  "chain_storage_view",
+  "chain_emit_events",
+  "chain_set_return",
+  "event",
+};
+
+/**
+ * Allocate or die, the emulator has no use for partial state
+ */
+static void *_xrealloc(void *ptr, size_t size) {
+  void *ret = realloc(ptr, size);
+  if (!ret && size) {
+    fprintf(stderr, "host: out of memory\n");
+    abort();
+  }
+  return ret;
+}
+
+/**
+ * FNV-1a
+ */
+static uint64_t _hash(const void *key, size_t key_size) {
+  const uint8_t *p = key;
+  uint64_t h = 14695981039346656037ULL;
+  for (size_t i = 0; i < key_size; i++) {
+    h ^= p[i];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+/**
+ * Addresses hash a word at a time, their bytes are already well spread
+ */
+static uint64_t _hash_address(const uint8_t *address) {
+  uint64_t h = 0, word;
+  for (size_t i = 0; i + sizeof(word) <= ADDRESS_SIZE; i += sizeof(word)) {
+    memcpy(&word, address + i, sizeof(word));
+    h = (h ^ word) * 0x9e3779b97f4a7c15ULL;
+    h ^= h >> 29;
+  }
+  for (size_t i = ADDRESS_SIZE & ~(sizeof(word) - 1); i < ADDRESS_SIZE; i++) {
+    h = (h ^ address[i]) * 0x9e3779b97f4a7c15ULL;
+  }
+  return h ^ (h >> 32);
+}
+
+static uint32_t *_xcalloc_slots(size_t count) {
+  uint32_t *slots = calloc(count, sizeof(uint32_t));
+  if (!slots) {
+    fprintf(stderr, "host: out of memory\n");
+    abort();
+  }
+  return slots;
+}
+
+static void _rehash(host_t *host, size_t slot_count) {
+  free(host->slots);
+  host->slots = _xcalloc_slots(slot_count);
+  host->slot_count = slot_count;
+  for (size_t i = 0; i < host->entry_count; i++) {
+    if (host->entries[i].account) {
+      continue;
+    }
+    size_t slot = host->entries[i].hash & (slot_count - 1);
+    while (host->slots[slot]) {
+      slot = (slot + 1) & (slot_count - 1);
+    }
+    host->slots[slot] = (uint32_t)(i + 1);
+  }
+}
+
+/**
+ * Return the slot holding key, or the empty slot where it would go
+ */
+static size_t _probe(const host_t *host, const void *key, size_t key_size, uint64_t hash) {
+  size_t mask = host->slot_count - 1;
+  size_t slot = hash & mask;
+  for (;;) {
+    uint32_t index = host->slots[slot];
+    if (!index) {
+      return slot;
+    }
+    const entry_t *entry = &host->entries[index - 1];
+    if (entry->hash == hash && entry->key_size == key_size && memcmp(entry->key, key, key_size) == 0) {
+      return slot;
+    }
+    slot = (slot + 1) & mask;
+  }
+}
+
+static void _rehash_accounts(host_t *host, size_t slot_count) {
+  free(host->account_slots);
+  host->account_slots = _xcalloc_slots(slot_count);
+  host->account_slot_count = slot_count;
+  for (size_t i = 0; i < host->account_count; i++) {
+    size_t slot = _hash_address(host->addresses[i]) & (slot_count - 1);
+    while (host->account_slots[slot]) {
+      slot = (slot + 1) & (slot_count - 1);
+    }
+    host->account_slots[slot] = (uint32_t)(i + 1);
+  }
+}
+
+/**
+ * Return the account slot holding address, or the empty slot where it would go
+ */
+static size_t _probe_account(const host_t *host, const uint8_t *address, uint64_t hash) {
+  size_t mask = host->account_slot_count - 1;
+  size_t slot = hash & mask;
+  for (;;) {
+    uint32_t id = host->account_slots[slot];
+    if (!id || memcmp(host->addresses[id - 1], address, ADDRESS_SIZE) == 0) {
+      return slot;
+    }
+    slot = (slot + 1) & mask;
+  }
+}
+
+static int _is_balance_key(const void *key, size_t key_size) {
+  return key_size == BALANCES_KEY_SIZE && memcmp(key, BALANCES_PREFIX, sizeof(BALANCES_PREFIX)) == 0;
+}
+
+static entry_t *_lookup_hashed(const host_t *host, const void *key, size_t key_size, uint64_t hash) {
+  uint32_t index = host->slots[_probe(host, key, key_size, hash)];
+  return index ? &host->entries[index - 1] : NULL;
+}
+
+static entry_t *_lookup(const host_t *host, const void *key, size_t key_size) {
+  if (_is_balance_key(key, key_size)) {
+    uint32_t account = host_account(host, (const uint8_t *)key + sizeof(BALANCES_PREFIX));
+    uint32_t index = account != HOST_NO_ACCOUNT ? host->balances[account] : 0;
+    return index ? &host->entries[index - 1] : NULL;
+  }
+  return _lookup_hashed(host, key, key_size, _hash(key, key_size));
+}
+
+static size_t _append(host_t *host, const void *key, size_t key_size, uint64_t hash) {
+  if (host->entry_count == host->entry_capacity) {
+    host->entry_capacity = host->entry_capacity ? host->entry_capacity * 2 : INITIAL_SLOTS / 2;
+    host->entries = _xrealloc(host->entries, host->entry_capacity * sizeof(entry_t));
+  }
+  size_t index = host->entry_count++;
+  entry_t *entry = &host->entries[index];
+  entry->hash = hash;
+  entry->key = _xrealloc(NULL, key_size ? key_size : 1);
+  memcpy(entry->key, key, key_size);
+  entry->key_size = key_size;
+  entry->value = NULL;
+  entry->value_size = 0;
+  entry->value_capacity = 0;
+  entry->account = 0;
+  return index;
+}
+
+static size_t _insert(host_t *host, const void *key, size_t key_size) {
+  if (_is_balance_key(key, key_size)) {
+    uint32_t account = host_intern(host, (const uint8_t *)key + sizeof(BALANCES_PREFIX));
+    if (!host->balances[account]) {
+      size_t index = _append(host, key, key_size, 0);
+      host->entries[index].account = 1;
+      host->balances[account] = (uint32_t)(index + 1);
+    }
+    return host->balances[account] - 1;
+  }
+  uint64_t hash = _hash(key, key_size);
+  size_t slot = _probe(host, key, key_size, hash);
+  if (host->slots[slot]) {
+    return host->slots[slot] - 1;
+  }
+  size_t index = _append(host, key, key_size, hash);
+  host->slots[slot] = (uint32_t)(index + 1);
+  // Keep load factor under 1/2
+  if (++host->slot_entry_count * 2 > host->slot_count) {
+    _rehash(host, host->slot_count * 2);
+  }
+  return index;
+}
+
+static void _assign(entry_t *entry, const void *value, size_t value_size) {
+  if (value_size > entry->value_capacity) {
+    entry->value = _xrealloc(entry->value, value_size);
+    entry->value_capacity = value_size;
+  }
+  if (value_size) {
+    memcpy(entry->value, value, value_size);
+  }
+  entry->value_size = value_size;
+}
+
+static void _observe(const host_t *host, host_import_t import, const void *key, size_t key_size, size_t value_size) {
+  for (size_t i = 0; i < host->observer_count; i++) {
+    const host_observer_t *observer = host->observers[i];
+    if (observer->import) {
+      observer->import(observer->ctx, import, key, key_size, value_size);
+    }
+  }
+}
+
+/**
+ * Save the current value of an entry so an abort can restore it
+ */
+static void _journal(host_t *host, size_t index) {
+  const entry_t *entry = &host->entries[index];
+  if (host->undo_count == host->undo_capacity) {
+    host->undo_capacity = host->undo_capacity ? host->undo_capacity * 2 : 16;
+    host->undo = _xrealloc(host->undo, host->undo_capacity * sizeof(undo_t));
+  }
+  if (host->undo_bytes_size + entry->value_size > host->undo_bytes_capacity) {
+    while (host->undo_bytes_size + entry->value_size > host->undo_bytes_capacity) {
+      host->undo_bytes_capacity = host->undo_bytes_capacity ? host->undo_bytes_capacity * 2 : 256;
+    }
+    host->undo_bytes = _xrealloc(host->undo_bytes, host->undo_bytes_capacity);
+  }
+  undo_t *undo = &host->undo[host->undo_count++];
+  undo->entry = index;
+  undo->offset = host->undo_bytes_size;
+  undo->size = entry->value_size;
+  if (entry->value_size) {
+    memcpy(host->undo_bytes + host->undo_bytes_size, entry->value, entry->value_size);
+  }
+  host->undo_bytes_size += entry->value_size;
+}
+
+static void _rollback(host_t *host) {
+  while (host->undo_count) {
+    const undo_t *undo = &host->undo[--host->undo_count];
+    _assign(&host->entries[undo->entry], host->undo_bytes + undo->offset, undo->size);
+  }
+  host->undo_bytes_size = 0;
+}
+
+host_t *host_new(void) {
+  host_t *host = _xrealloc(NULL, sizeof(host_t));
+  memset(host, 0, sizeof(host_t));
+  _rehash(host, INITIAL_SLOTS);
+  _rehash_accounts(host, INITIAL_ACCOUNT_SLOTS);
+  return host;
+}
+
+void host_free(host_t *host) {
+  if (!host) {
+    return;
+  }
+  if (selected == host) {
+    selected = NULL;
+  }
+  host_reset(host);
+  free(host->entries);
+  free(host->slots);
+  free(host->addresses);
+  free(host->balances);
+  free(host->account_slots);
+  free(host->events);
+  free(host->undo);
+  free(host->undo_bytes);
+  free(host->return_data);
+  free(host);
+}
+
+void host_reset(host_t *host) {
+  for (size_t i = 0; i < host->entry_count; i++) {
+    free(host->entries[i].key);
+    free(host->entries[i].value);
+  }
+  host->entry_count = 0;
+  host->slot_entry_count = 0;
+  memset(host->slots, 0, host->slot_count * sizeof(uint32_t));
+  host->account_count = 0;
+  memset(host->account_slots, 0, host->account_slot_count * sizeof(uint32_t));
+  host->event_count = 0;
+  host->undo_count = 0;
+  host->undo_bytes_size = 0;
+}
+
+void host_select(host_t *host) {
+  selected = host;
+}
+
+host_t *host_selected(void) {
+  return selected;
+}
+
+void host_set_caller(host_t *host, const uint8_t address[ADDRESS_SIZE]) {
+  memcpy(host->caller, address, ADDRESS_SIZE);
+}
+
+void host_set_creator(host_t *host, const uint8_t address[ADDRESS_SIZE]) {
+  memcpy(host->creator, address, ADDRESS_SIZE);
+}
+
+const void *host_storage_find(const host_t *host, const void *key, size_t key_size, size_t *value_size) {
+  const entry_t *entry = _lookup(host, key, key_size);
+  *value_size = entry ? entry->value_size : 0;
+  return entry && entry->value_size ? entry->value : NULL;
+}
+
+uint32_t host_intern(host_t *host, const uint8_t address[ADDRESS_SIZE]) {
+  size_t slot = _probe_account(host, address, _hash_address(address));
+  if (host->account_slots[slot]) {
+    return host->account_slots[slot] - 1;
+  }
+  if (host->account_count == host->account_capacity) {
+    host->account_capacity = host->account_capacity ? host->account_capacity * 2 : INITIAL_ACCOUNT_SLOTS / 2;
+    host->addresses = _xrealloc(host->addresses, host->account_capacity * ADDRESS_SIZE);
+    host->balances = _xrealloc(host->balances, host->account_capacity * sizeof(uint32_t));
+  }
+  uint32_t account = (uint32_t)host->account_count++;
+  memcpy(host->addresses[account], address, ADDRESS_SIZE);
+  host->balances[account] = 0;
+  host->account_slots[slot] = account + 1;
+  // Keep load factor under 1/2
+  if (host->account_count * 2 > host->account_slot_count) {
+    _rehash_accounts(host, host->account_slot_count * 2);
+  }
+  return account;
+}
+
+uint32_t host_account(const host_t *host, const uint8_t address[ADDRESS_SIZE]) {
+  uint32_t id = host->account_slots[_probe_account(host, address, _hash_address(address))];
+  return id ? id - 1 : HOST_NO_ACCOUNT;
+}
+
+size_t host_account_count(const host_t *host) {
+  return host->account_count;
+}
+
+const uint8_t *host_account_address(const host_t *host, uint32_t account) {
+  return account < host->account_count ? host->addresses[account] : NULL;
+}
+
+const void *host_account_balance(const host_t *host, uint32_t account, size_t *value_size) {
+  uint32_t index = account < host->account_count ? host->balances[account] : 0;
+  const entry_t *entry = index ? &host->entries[index - 1] : NULL;
+  *value_size = entry ? entry->value_size : 0;
+  return entry && entry->value_size ? entry->value : NULL;
+}
+
+void host_storage_put(host_t *host, const void *key, size_t key_size, const void *value, size_t value_size) {
+  // _insert may move the entries, index them only after it
+  size_t index = _insert(host, key, key_size);
+  _assign(&host->entries[index], value, value_size);
+}
+
+size_t host_prefetch(const host_t *host, const uint8_t *list, size_t size) {
+  size_t mask = host->slot_count - 1;
+  uint64_t hashes[HOST_ACCESS_SIZE / 2];
+  size_t offsets[HOST_ACCESS_SIZE / 2];
+  size_t count = 0;
+  // Issue every slot load before waiting on any of them, then the entries
+  for (size_t offset = 0; offset < size && count < HOST_ACCESS_SIZE / 2; offset += 1 + list[offset]) {
+    if (!list[offset] || offset + 1 + list[offset] > size) {
+      break;
+    }
+    offsets[count] = offset;
+    if (_is_balance_key(list + offset + 1, list[offset])) {
+      hashes[count] = _hash_address(list + offset + 1 + sizeof(BALANCES_PREFIX));
+      __builtin_prefetch(&host->account_slots[hashes[count] & (host->account_slot_count - 1)]);
+    } else {
+      hashes[count] = _hash(list + offset + 1, list[offset]);
+      __builtin_prefetch(&host->slots[hashes[count] & mask]);
+    }
+    count++;
+  }
+  for (size_t i = 0; i < count; i++) {
+    const uint8_t *key = list + offsets[i] + 1;
+    const entry_t *entry = _is_balance_key(key, list[offsets[i]])
+                             ? _lookup(host, key, list[offsets[i]])
+                             : _lookup_hashed(host, key, list[offsets[i]], hashes[i]);
+    if (entry && entry->value) {
+      __builtin_prefetch(entry->value);
+    }
+  }
+  return count;
+}
+
+size_t host_storage_count(const host_t *host) {
+  return host->entry_count;
+}
+
+size_t host_storage_bytes(const host_t *host) {
+  size_t bytes = 0;
+  for (size_t i = 0; i < host->entry_count; i++) {
+    if (host->entries[i].value_size) {
+      bytes += host->entries[i].key_size + host->entries[i].value_size;
+    }
+  }
+  return bytes;
+}
+
+const host_event_t *host_events(const host_t *host, size_t *count) {
+  *count = host->event_count;
+  return host->events;
+}
+
+void host_clear_events(host_t *host) {
+  host->event_count = 0;
+  host->call_event_count = 0;
+}
+
+/**
+ * Refuse a write or an event of a read-only invocation, which then aborts
+ */
+static int _refuse(host_t *host) {
+  if (host->read_only) {
+    host->refused = 1;
+  }
+  return host->read_only;
+}
+
+void host_emit(host_event_kind_t kind, const uint8_t *a, const uint8_t *b, uint64_t v0, uint64_t v1) {
+  host_t *host = selected;
+  host->stats.host_calls++;
+  if (_refuse(host)) {
+    return;
+  }
+  if (host->observer_count) {
+    _observe(host, HOST_IMPORT_EVENT, NULL, 0, 0);
+  }
+  if (host->event_count == host->event_capacity) {
+    host->event_capacity = host->event_capacity ? host->event_capacity * 2 : 64;
+    host->events = _xrealloc(host->events, host->event_capacity * sizeof(host_event_t));
+  }
+  host_event_t *event = &host->events[host->event_count++];
+  event->kind = kind;
+  if (a) {
+    memcpy(event->addresses[0], a, ADDRESS_SIZE);
+  }
+  if (b) {
+    memcpy(event->addresses[1], b, ADDRESS_SIZE);
+  }
+  event->values[0] = v0;
+  event->values[1] = v1;
+}
+
+// Parameters of each event kind
+static const struct {
+  uint8_t addresses;
+  uint8_t values;
+} event_shapes[] = {
+  [HOST_EVENT_OWNER] = {1, 0},
+  [HOST_EVENT_CHANGE_OWNER] = {2, 0},
+  [HOST_EVENT_MINT] = {1, 1},
+  [HOST_EVENT_BURN] = {1, 1},
+  [HOST_EVENT_TRANSFER] = {2, 2},
+  [HOST_EVENT_APPROVAL] = {2, 1},
+  [HOST_EVENT_PAUSE] = {0, 0},
+  [HOST_EVENT_UNPAUSE] = {0, 0},
+};
+
+/**
+ * Decode a buffer of events, the kind in one byte then the parameters. Check
+ * it all first and grow the log once, so a bad buffer appends nothing.
+ * Buffers over HOST_EVENTS_SIZE are refused whole.
+ */
+int chain_emit_events(const void *buffer, size_t size) {
+  host_t *host = selected;
+  host->stats.host_calls++;
+  if (size > HOST_EVENTS_SIZE || _refuse(host)) {
+    return -1;
+  }
+  if (host->observer_count) {
+    _observe(host, HOST_IMPORT_EMIT_EVENTS, NULL, 0, size);
+  }
+  const uint8_t *bytes = buffer;
+  size_t count = 0;
+  for (size_t offset = 0; offset < size; count++) {
+    if (bytes[offset] >= sizeof(event_shapes) / sizeof(event_shapes[0])) {
+      return -1;
+    }
+    offset += 1 + event_shapes[bytes[offset]].addresses * ADDRESS_SIZE +
+              event_shapes[bytes[offset]].values * sizeof(uint64_t);
+    if (offset > size) {
+      return -1;
+    }
+  }
+  if (host->event_count + count > host->event_capacity) {
+    while (host->event_count + count > host->event_capacity) {
+      host->event_capacity = host->event_capacity ? host->event_capacity * 2 : 64;
+    }
+    host->events = _xrealloc(host->events, host->event_capacity * sizeof(host_event_t));
+  }
+  for (size_t offset = 0; offset < size;) {
+    host_event_t *event = &host->events[host->event_count++];
+    memset(event, 0, sizeof(host_event_t));
+    event->kind = bytes[offset++];
+    for (int i = 0; i < event_shapes[event->kind].addresses; i++, offset += ADDRESS_SIZE) {
+      memcpy(event->addresses[i], bytes + offset, ADDRESS_SIZE);
+    }
+    for (int i = 0; i < event_shapes[event->kind].values; i++, offset += sizeof(uint64_t)) {
+      memcpy(&event->values[i], bytes + offset, sizeof(uint64_t));
+    }
+  }
+  return 0;
+}
+
+const host_stats_t *host_stats(const host_t *host) {
+  return &host->stats;
+}
+
+void host_reset_stats(host_t *host) {
+  memset(&host->stats, 0, sizeof(host_stats_t));
+}
+
+int host_add_observer(host_t *host, const host_observer_t *observer) {
+  if (host->observer_count == HOST_MAX_OBSERVERS) {
+    return -1;
+  }
+  host->observers[host->observer_count++] = observer;
+  return 0;
+}
+
+void host_remove_observer(host_t *host, const host_observer_t *observer) {
+  for (size_t i = 0; i < host->observer_count; i++) {
+    if (host->observers[i] == observer) {
+      memmove(&host->observers[i], &host->observers[i + 1], (host->observer_count - i - 1) * sizeof(observer));
+      host->observer_count--;
+      return;
+    }
+  }
+}
+
+const char *host_import_name(host_import_t import) {
+  return import < HOST_IMPORT_COUNT ? import_names[import] : "unknown";
+}
+
+void *host_contract_malloc(size_t size) {
+  if (selected) {
+    selected->stats.allocations++;
+    selected->stats.bytes_allocated += size;
+  }
+  return malloc(size);
+}
+
+void host_contract_free(void *ptr) {
+  free(ptr);
+}
+
+jmp_buf *host_begin(host_t *host, const char *call) {
+  selected = host;
+  for (size_t i = 0; i < host->observer_count; i++) {
+    if (host->observers[i]->begin) {
+      host->observers[i]->begin(host->observers[i]->ctx, call);
+    }
+  }
+  host->in_call = 1;
+  host->read_only = 0;
+  host->refused = 0;
+  host->return_size = 0;
+  host->call_event_count = host->event_count;
+  host->undo_count = 0;
+  host->undo_bytes_size = 0;
+  return &host->abort_point;
+}
+
+void host_read_only(host_t *host) {
+  host->read_only = 1;
+}
+
+const void *host_return_data(const host_t *host, size_t *size) {
+  *size = host->return_size;
+  return host->return_size ? host->return_data : NULL;
+}
+
+int host_end(host_t *host, int aborted) {
+  aborted |= host->refused;
+  if (aborted) {
+    _rollback(host);
+    host->event_count = host->call_event_count;
+    host->return_size = 0;
+  }
+  host->undo_count = 0;
+  host->undo_bytes_size = 0;
+  host->in_call = 0;
+  int status = aborted ? HOST_ABORTED : HOST_OK;
+  for (size_t i = 0; i < host->observer_count; i++) {
+    if (host->observers[i]->end) {
+      host->observers[i]->end(host->observers[i]->ctx, status);
+    }
+  }
+  return status;
+}
+
+void host_abort(int status) {
+  if (!selected || !selected->in_call) {
+    fprintf(stderr, "host: contract exited with %d outside of an invocation\n", status);
+    abort();
+  }
+  longjmp(selected->abort_point, 1);
+}
+
+static void _access(const host_t *host, host_import_t import, const void *key, size_t key_size, size_t value_size) {
+  for (size_t i = 0; i < host->observer_count; i++) {
+    const host_observer_t *observer = host->observers[i];
+    if (observer->access) {
+      observer->access(observer->ctx, import, key, key_size, value_size);
+    }
+  }
+}
+
+// Imports
+
+size_t chain_storage_size_get(const void *key, size_t key_size) {
+  host_t *host = selected;
+  host->stats.host_calls++;
+  if (host->observer_count) {
+    _observe(host, HOST_IMPORT_STORAGE_SIZE_GET, key, key_size, 0);
+  }
+  const entry_t *entry = _lookup(host, key, key_size);
+  return entry ? entry->value_size : 0;
+}
+
+int chain_storage_get(const void *key, size_t key_size, void *value) {
+  host_t *host = selected;
+  host->stats.host_calls++;
+  const entry_t *entry = _lookup(host, key, key_size);
+  size_t size = entry ? entry->value_size : 0;
+  if (host->observer_count) {
+    _observe(host, HOST_IMPORT_STORAGE_GET, key, key_size, size);
+  }
+  if (!size) {
+    return 0;
+  }
+  host->stats.storage_bytes_read += size;
+  memcpy(value, entry->value, size);
+  return (int)size;
+}
+
+size_t chain_storage_read(const void *key, size_t key_size, void *value, size_t value_size) {
+  host_t *host = selected;
+  host->stats.host_calls++;
+  const entry_t *entry = _lookup(host, key, key_size);
+  size_t size = entry ? entry->value_size : 0;
+  size_t copied = size < value_size ? size : value_size;
+  if (host->observer_count) {
+    _observe(host, HOST_IMPORT_STORAGE_READ, key, key_size, copied);
+  }
+  if (copied) {
+    host->stats.storage_bytes_read += copied;
+    memcpy(value, entry->value, copied);
+  }
+  return size;
+}
+
+/**
+ * Point at the stored value itself, nothing is copied. Each entry holds its
+ * value in its own buffer, so the view stays valid until that key is written
+ * or the invocation returns.
+ */
+const void *chain_storage_view(const void *key, size_t key_size, size_t *value_size) {
+  host_t *host = selected;
+  host->stats.host_calls++;
+  const entry_t *entry = _lookup(host, key, key_size);
+  size_t size = entry ? entry->value_size : 0;
+  if (host->observer_count) {
+    _observe(host, HOST_IMPORT_STORAGE_VIEW, key, key_size, size);
+  }
+  host->stats.storage_bytes_read += size;
+  *value_size = size;
+  return size ? entry->value : NULL;
+}
+
+void chain_storage_get_many(size_t count, const void *const keys[], const size_t key_sizes[],
+                            void *const values[], size_t value_sizes[]) {
+  host_t *host = selected;
+  size_t key_bytes = 0, value_bytes = 0;
+  host->stats.host_calls++;
+  for (size_t i = 0; i < count; i++) {
+    const entry_t *entry = _lookup(host, keys[i], key_sizes[i]);
+    size_t size = entry ? entry->value_size : 0;
+    size_t copied = size < value_sizes[i] ? size : value_sizes[i];
+    if (copied) {
+      memcpy(values[i], entry->value, copied);
+    }
+    if (host->observer_count) {
+      _access(host, HOST_IMPORT_STORAGE_GET_MANY, keys[i], key_sizes[i], copied);
+    }
+    key_bytes += key_sizes[i];
+    value_bytes += copied;
+    value_sizes[i] = size;
+  }
+  host->stats.storage_bytes_read += value_bytes;
+  if (host->observer_count) {
+    _observe(host, HOST_IMPORT_STORAGE_GET_MANY, NULL, key_bytes, value_bytes);
+  }
+}
+
+int chain_storage_set(const void *key, size_t key_size, const void *value, size_t value_size) {
+  host_t *host = selected;
+  host->stats.host_calls++;
+  if (_refuse(host)) {
+    return -1;
+  }
+  host->stats.storage_bytes_written += value_size;
+  if (host->observer_count) {
+    _observe(host, HOST_IMPORT_STORAGE_SET, key, key_size, value_size);
+  }
+  size_t index = _insert(host, key, key_size);
+  if (host->in_call) {
+    _journal(host, index);
+  }
+  _assign(&host->entries[index], value, value_size);
+  return 0;
+}
+
+void chain_storage_set_many(size_t count, const void *const keys[], const size_t key_sizes[],
+                            const void *const values[], const size_t value_sizes[]) {
+  host_t *host = selected;
+  size_t key_bytes = 0, value_bytes = 0;
+  host->stats.host_calls++;
+  if (_refuse(host)) {
+    return;
+  }
+  // Applied in order, a key written twice keeps its last value. The batch is
+  // journaled like single writes, so it rolls back as a whole.
+  for (size_t i = 0; i < count; i++) {
+    size_t index = _insert(host, keys[i], key_sizes[i]);
+    if (host->in_call) {
+      _journal(host, index);
+    }
+    _assign(&host->entries[index], values[i], value_sizes[i]);
+    if (host->observer_count) {
+      _access(host, HOST_IMPORT_STORAGE_SET_MANY, keys[i], key_sizes[i], value_sizes[i]);
+    }
+    key_bytes += key_sizes[i];
+    value_bytes += value_sizes[i];
+  }
+  host->stats.storage_bytes_written += value_bytes;
+  if (host->observer_count) {
+    _observe(host, HOST_IMPORT_STORAGE_SET_MANY, NULL, key_bytes, value_bytes);
+  }
+}
+
+/**
+ * Last index before i listing the same key, -1 if none
+ */
+static ptrdiff_t _earlier(const void *const keys[], const size_t key_sizes[], size_t i) {
+  for (ptrdiff_t j = (ptrdiff_t)i - 1; j >= 0; j--) {
+    if (key_sizes[j] == key_sizes[i] && memcmp(keys[j], keys[i], key_sizes[i]) == 0) {
+      return j;
+    }
+  }
+  return -1;
+}
+
+int chain_storage_delta_u64(size_t count, const void *const keys[], const size_t key_sizes[],
+                            const uint64_t add[], const uint64_t sub[]) {
+  host_t *host = selected;
+  uint64_t values[HOST_MAX_DELTAS];
+  size_t key_bytes = 0;
+  host->stats.host_calls++;
+  if (count > HOST_MAX_DELTAS || _refuse(host)) {
+    return -1;
+  }
+  // Check everything first, then apply all or nothing. A key listed twice
+  // sees the result of its earlier entry.
+  int failed = 0;
+  for (size_t i = 0; i < count && !failed; i++) {
+    ptrdiff_t earlier = _earlier(keys, key_sizes, i);
+    uint64_t value = 0;
+    if (earlier >= 0) {
+      value = values[earlier];
+    } else {
+      const entry_t *entry = _lookup(host, keys[i], key_sizes[i]);
+      if (entry && entry->value_size == sizeof(uint64_t)) {
+        memcpy(&value, entry->value, sizeof(uint64_t));
+      } else if (entry && entry->value_size) {
+        failed = (int)i + 1;
+      }
+    }
+    if (value + add[i] < value || value + add[i] < sub[i]) {
+      failed = (int)i + 1;
+    }
+    values[i] = value + add[i] - sub[i];
+    key_bytes += key_sizes[i];
+  }
+  if (host->observer_count) {
+    _observe(host, HOST_IMPORT_STORAGE_DELTA_U64, NULL, key_bytes, failed ? 0 : count * sizeof(uint64_t));
+  }
+  if (failed) {
+    return failed;
+  }
+  for (size_t i = 0; i < count; i++) {
+    size_t index = _insert(host, keys[i], key_sizes[i]);
+    if (host->in_call) {
+      _journal(host, index);
+    }
+    _assign(&host->entries[index], &values[i], sizeof(uint64_t));
+    if (host->observer_count) {
+      _access(host, HOST_IMPORT_STORAGE_DELTA_U64, keys[i], key_sizes[i], sizeof(uint64_t));
+    }
+  }
+  host->stats.storage_bytes_written += count * sizeof(uint64_t);
+  return 0;
+}
+
+/**
+ * Replace the return data of the invocation, allowed in read-only ones too
+ */
+void chain_set_return(const void *data, size_t size) {
+  host_t *host = selected;
+  host->stats.host_calls++;
+  if (host->observer_count) {
+    _observe(host, HOST_IMPORT_SET_RETURN, NULL, 0, size);
+  }
+  if (size > host->return_capacity) {
+    host->return_data = _xrealloc(host->return_data, size);
+    host->return_capacity = size;
+  }
+  if (size) {
+    memcpy(host->return_data, data, size);
+  }
+  host->return_size = size;
+}
+
+void chain_get_caller(uint8_t address[ADDRESS_SIZE]) {
+  host_t *host = selected;
+  host->stats.host_calls++;
+  if (host->observer_count) {
+    _observe(host, HOST_IMPORT_GET_CALLER, NULL, 0, ADDRESS_SIZE);
+  }
+  memcpy(address, host->caller, ADDRESS_SIZE);
+}
+
+void chain_get_creator(uint8_t address[ADDRESS_SIZE]) {
+  host_t *host = selected;
+  host->stats.host_calls++;
+  if (host->observer_count) {
+    _observe(host, HOST_IMPORT_GET_CREATOR, NULL, 0, ADDRESS_SIZE);
+  }
+  memcpy(address, host->creator, ADDRESS_SIZE);
+}
@@ -0,0 +1,265 @@
+//
+//  host.h
+//  Native host emulator for the sample contracts
+//
+
+#ifndef host_h
+#define host_h
+
+#include <setjmp.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef ADDRESS_SIZE
+#define ADDRESS_SIZE 35
+#endif
+
+// Status of an invocation
+#define HOST_OK 0
+#define HOST_ABORTED 1
+
+typedef struct host host_t;
+
+// Events emitted by the contracts, in the order of the qash ABI. Arguments
+// are stored in the order of the event signature: addresses first, then
+// uint64 values.
+typedef enum {
+  HOST_EVENT_OWNER,
+  HOST_EVENT_CHANGE_OWNER,
+  HOST_EVENT_MINT,
+  HOST_EVENT_BURN,
+  HOST_EVENT_TRANSFER,
+  HOST_EVENT_APPROVAL,
+  HOST_EVENT_PAUSE,
+  HOST_EVENT_UNPAUSE,
+} host_event_kind_t;
+
+typedef struct {
+  host_event_kind_t kind;
+  uint8_t addresses[2][ADDRESS_SIZE];
+  uint64_t values[2];
+} host_event_t;
+
+// Imports a contract can cross into the host through
+typedef enum {
+  HOST_IMPORT_STORAGE_SIZE_GET,
+  HOST_IMPORT_STORAGE_GET,
+  HOST_IMPORT_STORAGE_SET,
+  HOST_IMPORT_GET_CALLER,
+  HOST_IMPORT_GET_CREATOR,
+  HOST_IMPORT_STORAGE_READ,
+  HOST_IMPORT_STORAGE_GET_MANY,
+  HOST_IMPORT_STORAGE_SET_MANY,
+  HOST_IMPORT_STORAGE_DELTA_U64,
+  HOST_IMPORT_STORAGE_VIEW,
+  HOST_IMPORT_EMIT_EVENTS,
+  HOST_IMPORT_SET_RETURN,
+  HOST_IMPORT_EVENT,
+  HOST_IMPORT_COUNT,
+} host_import_t;
+
+// Instrumentation hooks, any of them may be NULL.
+// begin receives the invoked expression as written in HOST_INVOKE.
+// import is called once per crossing with the key (NULL if the import has
+// none) and the number of value bytes that crossed the boundary. Batched
+// imports pass a NULL key and the totals, then call access for each key.
+typedef struct {
+  void (*begin)(void *ctx, const char *call);
+  void (*import)(void *ctx, host_import_t import, const void *key, size_t key_size, size_t value_size);
+  void (*access)(void *ctx, host_import_t import, const void *key, size_t key_size, size_t value_size);
+  void (*end)(void *ctx, int status);
+  void *ctx;
+} host_observer_t;
+
+#define HOST_MAX_OBSERVERS 4
+// Keys chain_storage_delta_u64 takes in one call
+#define HOST_MAX_DELTAS 16
+// Bytes of an access list: keys one after the other, each preceded by its
+// size in one byte
+#define HOST_ACCESS_SIZE 512
+// Bytes of events chain_emit_events takes in one call
+#define HOST_EVENTS_SIZE 1024
+
+// Counters since host_new or the last host_reset_stats
+typedef struct {
+  uint64_t host_calls;
+  uint64_t storage_bytes_read;
+  uint64_t storage_bytes_written;
+  uint64_t allocations;
+  uint64_t bytes_allocated;
+} host_stats_t;
+
+/**
+ * Create an empty host: no storage, zero caller and creator
+ */
+host_t *host_new(void);
+
+/**
+ * Release a host and everything it owns
+ */
+void host_free(host_t *host);
+
+/**
+ * Drop storage and events, keep caller and creator
+ */
+void host_reset(host_t *host);
+
+/**
+ * Make host the target of the chain_* imports
+ */
+void host_select(host_t *host);
+
+/**
+ * Return the host currently serving the chain_* imports
+ */
+host_t *host_selected(void);
+
+void host_set_caller(host_t *host, const uint8_t address[ADDRESS_SIZE]);
+void host_set_creator(host_t *host, const uint8_t address[ADDRESS_SIZE]);
+
+/**
+ * Direct storage access for setup and inspection, bypasses the imports.
+ * A missing key and an empty value are the same thing.
+ */
+const void *host_storage_find(const host_t *host, const void *key, size_t key_size, size_t *value_size);
+void host_storage_put(host_t *host, const void *key, size_t key_size, const void *value, size_t value_size);
+
+/**
+ * Accounts: addresses interned to dense IDs, 0, 1, ... in the order they are
+ * first stored under. Balance keys ("BALANCES\0" then the address) are held
+ * by account ID instead of in the key index, so scans over balances walk a
+ * flat array; chain_storage_* see no difference.
+ */
+#define HOST_NO_ACCOUNT UINT32_MAX
+
+/**
+ * ID of address, interning it if it has none yet
+ */
+uint32_t host_intern(host_t *host, const uint8_t address[ADDRESS_SIZE]);
+
+/**
+ * ID of address, HOST_NO_ACCOUNT if it was never interned
+ */
+uint32_t host_account(const host_t *host, const uint8_t address[ADDRESS_SIZE]);
+size_t host_account_count(const host_t *host);
+
+/**
+ * Address of an account, NULL if there is no such ID
+ */
+const uint8_t *host_account_address(const host_t *host, uint32_t account);
+
+/**
+ * Value of the balance key of an account, as host_storage_find would return it
+ */
+const void *host_account_balance(const host_t *host, uint32_t account, size_t *value_size);
+
+/**
+ * Fetch the keys of an access list ahead of the invocation touching them.
+ * A node would load them from cold storage in parallel here, the emulator
+ * brings their slots and values into the CPU cache. Return the number of
+ * keys, which stop at the first empty or truncated one.
+ */
+size_t host_prefetch(const host_t *host, const uint8_t *list, size_t size);
+
+/**
+ * Number of stored keys, including keys whose value was cleared
+ */
+size_t host_storage_count(const host_t *host);
+
+/**
+ * Key plus value bytes of the keys that hold a value
+ */
+size_t host_storage_bytes(const host_t *host);
+
+/**
+ * Events emitted since the last host_clear_events, in order
+ */
+const host_event_t *host_events(const host_t *host, size_t *count);
+void host_clear_events(host_t *host);
+
+/**
+ * Record an event on the selected host. Called by the native contract builds
+ * in place of the event imports.
+ */
+void host_emit(host_event_kind_t kind, const uint8_t *a, const uint8_t *b, uint64_t v0, uint64_t v1);
+
+const host_stats_t *host_stats(const host_t *host);
+void host_reset_stats(host_t *host);
+
+/**
+ * Attach an observer, it must outlive the host or be removed. Return 0, or -1
+ * when HOST_MAX_OBSERVERS are already attached.
+ */
+int host_add_observer(host_t *host, const host_observer_t *observer);
+void host_remove_observer(host_t *host, const host_observer_t *observer);
+
+const char *host_import_name(host_import_t import);
+
+/**
+ * Stand-ins for malloc() and free() inside contracts, counted in host_stats
+ */
+void *host_contract_malloc(size_t size);
+void host_contract_free(void *ptr);
+
+/**
+ * Begin an invocation of call on host and return its abort point.
+ * Prefer HOST_INVOKE.
+ */
+jmp_buf *host_begin(host_t *host, const char *call);
+
+/**
+ * Make the current invocation read-only: its writes and events are refused
+ * and end it HOST_ABORTED. Nothing is journaled for it.
+ */
+void host_read_only(host_t *host);
+
+/**
+ * Data the last invocation returned through chain_set_return, NULL if none
+ * or if it aborted. Valid until the next invocation.
+ */
+const void *host_return_data(const host_t *host, size_t *size);
+
+/**
+ * End the current invocation. An aborted invocation has its storage writes
+ * and events rolled back. Return HOST_OK or HOST_ABORTED.
+ */
+int host_end(host_t *host, int aborted);
+
+/**
+ * Stand-in for exit() inside contracts: unwind to the current invocation
+ */
+void host_abort(int status) __attribute__((noreturn));
+
+/**
+ * Run one contract call, e.g.
+ *   HOST_INVOKE(host, status, qash_transfer(to, 10, 0));
+ * status receives HOST_OK, or HOST_ABORTED if the contract exited.
+ */
+#define HOST_INVOKE(host, status, call)         \
+  do {                                          \
+    if (setjmp(*host_begin(host, #call)) == 0) { \
+      call;                                     \
+      (status) = host_end((host), 0);           \
+    } else {                                    \
+      (status) = host_end((host), 1);           \
+    }                                           \
+  } while (0)
+
+// Imports served to the contracts
+size_t chain_storage_size_get(const void *key, size_t key_size);
+int chain_storage_get(const void *key, size_t key_size, void *value);
+size_t chain_storage_read(const void *key, size_t key_size, void *value, size_t value_size);
+void chain_storage_get_many(size_t count, const void *const keys[], const size_t key_sizes[],
+                            void *const values[], size_t value_sizes[]);
+void chain_storage_set_many(size_t count, const void *const keys[], const size_t key_sizes[],
+                            const void *const values[], const size_t value_sizes[]);
+int chain_storage_delta_u64(size_t count, const void *const keys[], const size_t key_sizes[],
+                            const uint64_t add[], const uint64_t sub[]);
+int chain_storage_set(const void *key, size_t key_size, const void *value, size_t value_size);
+const void *chain_storage_view(const void *key, size_t key_size, size_t *value_size);
+int chain_emit_events(const void *buffer, size_t size);
+void chain_set_return(const void *data, size_t size);
+void chain_get_caller(uint8_t address[ADDRESS_SIZE]);
+void chain_get_creator(uint8_t address[ADDRESS_SIZE]);
+
+#endif /* host_h */
@@ -0,0 +1,24 @@
+//
+//  vertex.h
+//  Native stand-in for the toolchain header c/erc20/contract.c is built with
+//
+
+#ifndef vertex_h
+#define vertex_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#ifndef ADDRESS_SIZE
+#define ADDRESS_SIZE 35
+#endif
+typedef uint8_t byte_t;
+typedef byte_t *address;
+typedef int Event;
+extern size_t chain_storage_size_get(const void *, size_t);
+extern int chain_storage_get(const void *, size_t, void *);
+extern int chain_storage_set(const void *, size_t, const void *, size_t);
+// Copy the caller or creator into an ADDRESS_SIZE buffer
+extern void chain_get_caller(byte_t address[ADDRESS_SIZE]);
+extern void chain_get_creator(byte_t address[ADDRESS_SIZE]);
+
+#endif /* vertex_h */
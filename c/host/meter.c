@@ -0,0 +1,188 @@
+#include "meter.h"
+#include <string.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+void meter_default_schedule(meter_schedule_t *schedule) {
+  memset(schedule, 0, sizeof(meter_schedule_t));
+  schedule->instruction = 1;
+  for (int i = 0; i < HOST_IMPORT_COUNT; i++) {
+    schedule->host_call[i] = 40;
+  }
+  schedule->host_call[HOST_IMPORT_STORAGE_SIZE_GET] = 200;
+  schedule->host_call[HOST_IMPORT_STORAGE_GET] = 200;
+  schedule->host_call[HOST_IMPORT_STORAGE_READ] = 200;
+  schedule->host_call[HOST_IMPORT_STORAGE_GET_MANY] = 200;
+  schedule->host_call[HOST_IMPORT_STORAGE_SET_MANY] = 200;
+  schedule->host_call[HOST_IMPORT_STORAGE_DELTA_U64] = 200;
+  schedule->host_call[HOST_IMPORT_STORAGE_VIEW] = 200;
+  schedule->host_call[HOST_IMPORT_STORAGE_SET] = 200;
+  schedule->byte_read = 1;
+  schedule->byte_written = 8;
+}
+
+static meter_row_t *_row(meter_t *meter, const char *call) {
+  char name[METER_NAME_SIZE];
+  size_t size = strcspn(call, "( ");
+  if (size >= METER_NAME_SIZE) {
+    size = METER_NAME_SIZE - 1;
+  }
+  memcpy(name, call, size);
+  name[size] = 0;
+  for (size_t i = 0; i < meter->row_count; i++) {
+    if (strcmp(meter->rows[i].name, name) == 0) {
+      return &meter->rows[i];
+    }
+  }
+  if (meter->row_count == METER_MAX_ENTRYPOINTS) {
+    return NULL;
+  }
+  meter_row_t *row = &meter->rows[meter->row_count++];
+  memset(row, 0, sizeof(meter_row_t));
+  strcpy(row->name, name);
+  return row;
+}
+
+static void _begin(void *ctx, const char *call) {
+  meter_t *meter = ctx;
+  if (call != meter->last_call) {
+    meter->last_call = call;
+    meter->last_row = _row(meter, call);
+  }
+  meter->current = meter->last_row;
+  if (meter->counter) {
+    meter->start = meter->counter(meter->counter_ctx);
+  }
+}
+
+static void _import(void *ctx, host_import_t import, const void *key, size_t key_size, size_t value_size) {
+  meter_t *meter = ctx;
+  meter_row_t *row = meter->current;
+  (void)key;
+  if (!row) {
+    return;
+  }
+  row->host_calls[import]++;
+  if (import == HOST_IMPORT_STORAGE_GET || import == HOST_IMPORT_STORAGE_READ ||
+      import == HOST_IMPORT_STORAGE_GET_MANY || import == HOST_IMPORT_STORAGE_VIEW) {
+    row->bytes_read += value_size;
+  } else if (import == HOST_IMPORT_STORAGE_SET || import == HOST_IMPORT_STORAGE_SET_MANY ||
+             import == HOST_IMPORT_STORAGE_DELTA_U64) {
+    row->bytes_written += key_size + value_size;
+  }
+}
+
+static void _end(void *ctx, int status) {
+  meter_t *meter = ctx;
+  meter_row_t *row = meter->current;
+  if (!row) {
+    return;
+  }
+  if (meter->counter) {
+    row->instructions += meter->counter(meter->counter_ctx) - meter->start;
+  }
+  row->invocations++;
+  row->aborted += status != HOST_OK;
+  meter->current = NULL;
+}
+
+int meter_attach(meter_t *meter, host_t *host, const meter_schedule_t *schedule,
+                 uint64_t (*counter)(void *ctx), void *counter_ctx) {
+  memset(meter, 0, sizeof(meter_t));
+  meter->schedule = *schedule;
+  meter->counter = counter;
+  meter->counter_ctx = counter_ctx;
+  meter->observer.begin = _begin;
+  meter->observer.import = _import;
+  meter->observer.end = _end;
+  meter->observer.ctx = meter;
+  return host_add_observer(host, &meter->observer);
+}
+
+void meter_detach(meter_t *meter, host_t *host) {
+  host_remove_observer(host, &meter->observer);
+}
+
+static uint64_t _host_calls(const meter_row_t *row) {
+  uint64_t calls = 0;
+  for (int i = 0; i < HOST_IMPORT_COUNT; i++) {
+    calls += row->host_calls[i];
+  }
+  return calls;
+}
+
+double meter_cost(const meter_t *meter, const meter_row_t *row) {
+  const meter_schedule_t *schedule = &meter->schedule;
+  double gas = (double)row->instructions * schedule->instruction +
+               (double)row->bytes_read * schedule->byte_read +
+               (double)row->bytes_written * schedule->byte_written;
+  for (int i = 0; i < HOST_IMPORT_COUNT; i++) {
+    gas += (double)row->host_calls[i] * schedule->host_call[i];
+  }
+  return row->invocations ? gas / row->invocations : 0;
+}
+
+void meter_print(const meter_t *meter, FILE *out) {
+  fprintf(out, "%-24s %10s %8s %12s %10s %10s %10s %12s\n", "entrypoint", "calls", "aborted",
+          "instr", "host", "read B", "write B", "gas");
+  for (size_t i = 0; i < meter->row_count; i++) {
+    const meter_row_t *row = &meter->rows[i];
+    double per = row->invocations ? (double)row->invocations : 1.0;
+    char instructions[16] = "-";
+    if (meter->counter) {
+      snprintf(instructions, sizeof(instructions), "%.1f", row->instructions / per);
+    }
+    fprintf(out, "%-24s %10llu %8llu %12s %10.2f %10.2f %10.2f %12.1f\n", row->name,
+            (unsigned long long)row->invocations, (unsigned long long)row->aborted,
+            instructions, _host_calls(row) / per,
+            row->bytes_read / per, row->bytes_written / per, meter_cost(meter, row));
+  }
+}
+
+#ifdef __linux__
+
+static int _perf_fd = -2;
+
+static int _perf_open(void) {
+  if (_perf_fd == -2) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    _perf_fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+  }
+  return _perf_fd;
+}
+
+uint64_t meter_native_counter(void *ctx) {
+  uint64_t count = 0;
+  int fd = _perf_open();
+  (void)ctx;
+  if (fd < 0 || read(fd, &count, sizeof(count)) != sizeof(count)) {
+    return 0;
+  }
+  return count;
+}
+
+int meter_native_available(void) {
+  return _perf_open() >= 0;
+}
+
+#else
+
+uint64_t meter_native_counter(void *ctx) {
+  (void)ctx;
+  return 0;
+}
+
+int meter_native_available(void) {
+  return 0;
+}
+
+#endif
@@ -0,0 +1,89 @@
+//
+//  meter.h
+//  Gas-like cost profile per entrypoint: instructions, host calls and
+//  storage bytes, priced by a fee schedule
+//
+//  Instructions come from a pluggable counter sampled around every
+//  invocation: wasm_instructions for gas-instrumented modules, or the
+//  hardware counter of meter_native_counter for the native builds (which
+//  also counts the emulator work behind each import).
+//
+
+#ifndef meter_h
+#define meter_h
+
+#include <stdio.h>
+#include "host.h"
+
+#define METER_MAX_ENTRYPOINTS 64
+#define METER_NAME_SIZE 32
+
+// Fee of each unit, in gas
+typedef struct {
+  uint64_t instruction;
+  uint64_t host_call[HOST_IMPORT_COUNT];
+  uint64_t byte_read;
+  uint64_t byte_written;
+} meter_schedule_t;
+
+typedef struct {
+  char name[METER_NAME_SIZE];
+  uint64_t invocations;
+  uint64_t aborted;
+  uint64_t instructions;
+  uint64_t host_calls[HOST_IMPORT_COUNT];
+  // Value bytes returned by the storage reads
+  uint64_t bytes_read;
+  // Key and value bytes passed to the storage writes
+  uint64_t bytes_written;
+} meter_row_t;
+
+typedef struct {
+  host_observer_t observer;
+  meter_schedule_t schedule;
+  // Monotonic instruction count, NULL to meter host calls and bytes only
+  uint64_t (*counter)(void *ctx);
+  void *counter_ctx;
+  meter_row_t rows[METER_MAX_ENTRYPOINTS];
+  size_t row_count;
+  meter_row_t *current;
+  uint64_t start;
+  const char *last_call;
+  meter_row_t *last_row;
+} meter_t;
+
+/**
+ * Placeholder schedule to calibrate from measured profiles: 1 per
+ * instruction, 40 per host call (200 for storage access), 1 per byte read,
+ * 8 per byte written
+ */
+void meter_default_schedule(meter_schedule_t *schedule);
+
+/**
+ * Reset meter and attach it to host. counter may be NULL. Return -1 if host
+ * has no free observer slot.
+ */
+int meter_attach(meter_t *meter, host_t *host, const meter_schedule_t *schedule,
+                 uint64_t (*counter)(void *ctx), void *counter_ctx);
+void meter_detach(meter_t *meter, host_t *host);
+
+/**
+ * Gas of row averaged per invocation
+ */
+double meter_cost(const meter_t *meter, const meter_row_t *row);
+
+/**
+ * Print the profile averaged per invocation, one line per entrypoint in a
+ * fixed layout so runs of different builds can be diffed
+ */
+void meter_print(const meter_t *meter, FILE *out);
+
+/**
+ * User space instructions retired by this thread, from a perf counter opened
+ * on first use. counter_ctx is unused. Returns 0 when the counter is not
+ * available (not Linux, or perf_event_paranoid forbids it).
+ */
+uint64_t meter_native_counter(void *ctx);
+int meter_native_available(void);
+
+#endif /* meter_h */
@@ -0,0 +1,71 @@
+//
+//  qash.c
+//  Native build of c/qash/contract.c for the host emulator
+//
+//  Every global of the contract gets a qash_ prefix so the sample contracts
+//  can share one binary. exit() unwinds to the current HOST_INVOKE. Events
+//  reach the host through chain_emit_events, as in the wasm build.
+//
+//  Build with -DQASH_COMPACT_KEYS for the compact balance and allowance
+//  keys, -DQASH_ACCOUNT_RECORDS for one record per account under its
+//  balance key. qash__build_balance_key gives the key of either layout.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+
+#define exit host_abort
+
+#define ZERO_ADDRESS qash_ZERO_ADDRESS
+#define _assert qash__assert
+#define _build_balance_key qash__build_balance_key
+#define _build_allowance_key qash__build_allowance_key
+#define _read_both qash__read_both
+#define _migrate qash__migrate
+#define _migrate_balance qash__migrate_balance
+#define _migrate_allowance qash__migrate_allowance
+#define _legacy_access qash__legacy_access
+#define _move qash__move
+#define _write_supply qash__write_supply
+#define _transfer qash__transfer
+#define _is_owner qash__is_owner
+#define _is_new_owner qash__is_new_owner
+#define _is_paused qash__is_paused
+#define init qash_init
+#define get_owner qash_get_owner
+#define is_owner qash_is_owner
+#define propose_new_owner qash_propose_new_owner
+#define is_new_owner qash_is_new_owner
+#define claim_ownership qash_claim_ownership
+#define get_balance qash_get_balance
+#define is_paused qash_is_paused
+#define pause qash_pause
+#define unpause qash_unpause
+#define transfer qash_transfer
+#define get_allowance qash_get_allowance
+#define approve qash_approve
+#define transfer_from qash_transfer_from
+#define get_decimals qash_get_decimals
+#define get_symbol qash_get_symbol
+#define get_total_supply qash_get_total_supply
+#define mint qash_mint
+#define burn qash_burn
+#define pause_access qash_pause_access
+#define unpause_access qash_unpause_access
+#define transfer_access qash_transfer_access
+#define approve_access qash_approve_access
+#define transfer_from_access qash_transfer_from_access
+#define mint_access qash_mint_access
+#define burn_access qash_burn_access
+
+#define Owner qash_Owner
+#define ChangeOwner qash_ChangeOwner
+#define Mint qash_Mint
+#define Burn qash_Burn
+#define Transfer qash_Transfer
+#define Approval qash_Approval
+#define Pause qash_Pause
+#define Unpause qash_Unpause
+
+#include "../qash/contract.c"
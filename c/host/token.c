@@ -0,0 +1,47 @@
+//
+//  token.c
+//  Native build of c/token/contract.c for the host emulator
+//
+//  Every global of the contract gets a token_ prefix so the sample contracts
+//  can share one binary. Heap use goes through the host so it shows up in
+//  host_stats.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+
+#define malloc host_contract_malloc
+#define free host_contract_free
+
+#define OWNER token_OWNER
+#define IS_PAUSE token_IS_PAUSE
+#define sdk_caller_is_creator token_sdk_caller_is_creator
+#define caller_is_owner token_caller_is_owner
+#define set_owner token_set_owner
+#define pause token_pause
+#define unpause token_unpause
+#define is_pausing token_is_pausing
+#define get_balance token_get_balance
+#define change_balance token_change_balance
+#define set_owner_to_creator token_set_owner_to_creator
+#define mint token_mint
+#define transfer_with_memo token_transfer_with_memo
+#define transfer token_transfer
+
+#define Mint token_Mint
+#define Transfer token_Transfer
+
+#include "../token/contract.c"
+
+// Events
+
+Event Mint(address to, uint64_t amount) {
+  host_emit(HOST_EVENT_MINT, to, NULL, amount, 0);
+  return 0;
+}
+
+Event Transfer(address from, address to, uint64_t amount, uint64_t memo) {
+  host_emit(HOST_EVENT_TRANSFER, from, to, amount, memo);
+  return 0;
+}
@@ -0,0 +1,398 @@
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char magic[4] = {'V', 'T', 'R', 'C'};
+
+// Addresses and u64 values carried by each event kind
+static const uint8_t event_addresses[] = {1, 2, 1, 1, 2, 2, 0, 0};
+static const uint8_t event_values[] = {0, 0, 1, 1, 2, 1, 0, 0};
+
+typedef struct {
+  uint8_t *data;
+  size_t size;
+  size_t capacity;
+} buffer_t;
+
+// Keys written during one invocation, in first write order
+typedef struct {
+  host_observer_t observer;
+  buffer_t keys;
+  size_t count;
+} collector_t;
+
+struct trace_writer {
+  FILE *file;
+  const abi_contract_t *contract;
+  collector_t collector;
+  buffer_t record;
+  int failed;
+};
+
+struct trace {
+  uint8_t *data;
+  size_t size;
+  size_t offset;
+  const abi_contract_t *contract;
+  uint8_t creator[ADDRESS_SIZE];
+  collector_t collector;
+  // Writes and events of the last trace_check
+  buffer_t writes;
+  buffer_t events;
+};
+
+static void _reserve(buffer_t *buffer, size_t size) {
+  if (buffer->size + size <= buffer->capacity) {
+    return;
+  }
+  while (buffer->size + size > buffer->capacity) {
+    buffer->capacity = buffer->capacity ? buffer->capacity * 2 : 256;
+  }
+  buffer->data = realloc(buffer->data, buffer->capacity);
+  if (!buffer->data) {
+    fprintf(stderr, "trace: out of memory\n");
+    abort();
+  }
+}
+
+static void _put(buffer_t *buffer, const void *data, size_t size) {
+  _reserve(buffer, size);
+  if (size) {
+    memcpy(buffer->data + buffer->size, data, size);
+  }
+  buffer->size += size;
+}
+
+static void _put_u8(buffer_t *buffer, uint8_t value) {
+  _put(buffer, &value, 1);
+}
+
+static void _collect(void *ctx, host_import_t import, const void *key, size_t key_size, size_t value_size) {
+  collector_t *collector = ctx;
+  (void)value_size;
+  // Batches report their keys through access
+  if (!key || (import != HOST_IMPORT_STORAGE_SET && import != HOST_IMPORT_STORAGE_SET_MANY &&
+               import != HOST_IMPORT_STORAGE_DELTA_U64)) {
+    return;
+  }
+  const uint8_t *p = collector->keys.data;
+  for (size_t i = 0; i < collector->count; i++) {
+    if (p[0] == key_size && memcmp(p + 1, key, key_size) == 0) {
+      return;
+    }
+    p += 1 + p[0];
+  }
+  _put_u8(&collector->keys, (uint8_t)key_size);
+  _put(&collector->keys, key, key_size);
+  collector->count++;
+}
+
+static void _collector_init(collector_t *collector) {
+  memset(collector, 0, sizeof(collector_t));
+  collector->observer.import = _collect;
+  collector->observer.access = _collect;
+  collector->observer.ctx = collector;
+}
+
+/**
+ * Invoke with the collector attached, leave the keys written in it
+ */
+static int _invoke(collector_t *collector, host_t *host, const abi_function_t *function,
+                   const uint8_t caller[ADDRESS_SIZE], abi_args_t *args, int64_t *ret, size_t *first_event) {
+  collector->keys.size = 0;
+  collector->count = 0;
+  host_set_caller(host, caller);
+  host_events(host, first_event);
+  host_add_observer(host, &collector->observer);
+  int status = abi_invoke(host, function, args, ret);
+  host_remove_observer(host, &collector->observer);
+  return status;
+}
+
+static void _encode_writes(const collector_t *collector, const host_t *host, int status, buffer_t *out) {
+  if (status != HOST_OK) {
+    _put_u8(out, 0);
+    return;
+  }
+  _put_u8(out, (uint8_t)collector->count);
+  const uint8_t *p = collector->keys.data;
+  for (size_t i = 0; i < collector->count; i++) {
+    size_t value_size;
+    const void *value = host_storage_find(host, p + 1, p[0], &value_size);
+    _put(out, p, 1 + p[0]);
+    _put_u8(out, (uint8_t)value_size);
+    _put(out, value, value_size);
+    p += 1 + p[0];
+  }
+}
+
+static void _encode_events(const host_t *host, size_t first, buffer_t *out) {
+  size_t count;
+  const host_event_t *events = host_events(host, &count);
+  _put_u8(out, (uint8_t)(count - first));
+  for (size_t i = first; i < count; i++) {
+    const host_event_t *event = &events[i];
+    _put_u8(out, (uint8_t)event->kind);
+    for (int j = 0; j < event_addresses[event->kind]; j++) {
+      _put(out, event->addresses[j], ADDRESS_SIZE);
+    }
+    for (int j = 0; j < event_values[event->kind]; j++) {
+      _put(out, &event->values[j], sizeof(uint64_t));
+    }
+  }
+}
+
+// Writing
+
+trace_writer_t *trace_create(const char *path, const abi_contract_t *contract, const uint8_t creator[ADDRESS_SIZE]) {
+  FILE *file = fopen(path, "wb");
+  if (!file) {
+    return NULL;
+  }
+  trace_writer_t *writer = calloc(1, sizeof(trace_writer_t));
+  writer->file = file;
+  writer->contract = contract;
+  _collector_init(&writer->collector);
+
+  uint32_t version = TRACE_VERSION;
+  uint8_t name_size = (uint8_t)strlen(contract->name);
+  _put(&writer->record, magic, sizeof(magic));
+  _put(&writer->record, &version, sizeof(version));
+  _put_u8(&writer->record, name_size);
+  _put(&writer->record, contract->name, name_size);
+  _put(&writer->record, creator, ADDRESS_SIZE);
+  writer->failed |= fwrite(writer->record.data, 1, writer->record.size, file) != writer->record.size;
+  return writer;
+}
+
+int trace_call(trace_writer_t *writer, host_t *host, const abi_function_t *function,
+               const uint8_t caller[ADDRESS_SIZE], abi_args_t *args, int64_t *ret) {
+  int64_t result;
+  size_t first_event;
+  int status = _invoke(&writer->collector, host, function, caller, args, &result, &first_event);
+
+  buffer_t *record = &writer->record;
+  record->size = 0;
+  _put_u8(record, (uint8_t)(function - writer->contract->functions));
+  _put_u8(record, (uint8_t)status);
+  _put(record, caller, ADDRESS_SIZE);
+  for (size_t i = 0; function->params[i]; i++) {
+    if (function->params[i] == 'a') {
+      _put(record, args->address[i], ADDRESS_SIZE);
+    } else {
+      _put(record, &args->value[i], sizeof(uint64_t));
+    }
+  }
+  _put(record, &result, sizeof(result));
+  _encode_writes(&writer->collector, host, status, record);
+  _encode_events(host, first_event, record);
+  writer->failed |= fwrite(record->data, 1, record->size, writer->file) != record->size;
+
+  if (ret) {
+    *ret = result;
+  }
+  return status;
+}
+
+int trace_close(trace_writer_t *writer) {
+  int failed = writer->failed;
+  failed |= fclose(writer->file) != 0;
+  free(writer->collector.keys.data);
+  free(writer->record.data);
+  free(writer);
+  return failed ? -1 : 0;
+}
+
+// Reading
+
+trace_t *trace_load(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    return NULL;
+  }
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  trace_t *trace = calloc(1, sizeof(trace_t));
+  trace->data = malloc(size > 0 ? size : 1);
+  trace->size = size > 0 ? (size_t)size : 0;
+  int ok = fread(trace->data, 1, trace->size, file) == trace->size;
+  fclose(file);
+
+  // Header
+  uint32_t version;
+  char name[256];
+  size_t offset = sizeof(magic) + sizeof(version) + 1;
+  ok = ok && trace->size >= offset && memcmp(trace->data, magic, sizeof(magic)) == 0;
+  if (ok) {
+    memcpy(&version, trace->data + sizeof(magic), sizeof(version));
+    uint8_t name_size = trace->data[offset - 1];
+    ok = version == TRACE_VERSION && trace->size >= offset + name_size + ADDRESS_SIZE;
+    if (ok) {
+      memcpy(name, trace->data + offset, name_size);
+      name[name_size] = 0;
+      memcpy(trace->creator, trace->data + offset + name_size, ADDRESS_SIZE);
+      trace->contract = abi_contract(name);
+      trace->offset = offset + name_size + ADDRESS_SIZE;
+    }
+  }
+  if (!ok || !trace->contract) {
+    trace_free(trace);
+    return NULL;
+  }
+  _collector_init(&trace->collector);
+  return trace;
+}
+
+void trace_free(trace_t *trace) {
+  if (!trace) {
+    return;
+  }
+  free(trace->data);
+  free(trace->collector.keys.data);
+  free(trace->writes.data);
+  free(trace->events.data);
+  free(trace);
+}
+
+const abi_contract_t *trace_contract(const trace_t *trace) {
+  return trace->contract;
+}
+
+const uint8_t *trace_creator(const trace_t *trace) {
+  return trace->creator;
+}
+
+void trace_rewind(trace_t *trace) {
+  trace->offset = sizeof(magic) + sizeof(uint32_t) + 1 + strlen(trace->contract->name) + ADDRESS_SIZE;
+}
+
+// Bounds checked cursor over the loaded trace
+#define TAKE(n)                                       \
+  do {                                                \
+    if (offset + (n) > trace->size) return -1;        \
+    p = trace->data + offset;                         \
+    offset += (n);                                    \
+  } while (0)
+
+int trace_next(trace_t *trace, trace_record_t *record) {
+  size_t offset = trace->offset;
+  const uint8_t *p;
+  if (offset == trace->size) {
+    return 0;
+  }
+  TAKE(2 + ADDRESS_SIZE);
+  if (p[0] >= trace->contract->function_count) {
+    return -1;
+  }
+  record->function = &trace->contract->functions[p[0]];
+  record->status = p[1];
+  memcpy(record->caller, p + 2, ADDRESS_SIZE);
+  for (size_t i = 0; record->function->params[i]; i++) {
+    if (record->function->params[i] == 'a') {
+      TAKE(ADDRESS_SIZE);
+      memcpy(record->args.address[i], p, ADDRESS_SIZE);
+    } else {
+      TAKE(sizeof(uint64_t));
+      memcpy(&record->args.value[i], p, sizeof(uint64_t));
+    }
+  }
+  TAKE(sizeof(int64_t));
+  memcpy(&record->ret, p, sizeof(int64_t));
+
+  size_t start = offset;
+  TAKE(1);
+  for (uint8_t count = *p, i = 0; i < count; i++) {
+    size_t size;
+    TAKE(1);
+    size = *p;
+    TAKE(size);
+    TAKE(1);
+    size = *p;
+    TAKE(size);
+  }
+  record->writes = trace->data + start;
+  record->writes_size = offset - start;
+
+  start = offset;
+  TAKE(1);
+  for (uint8_t count = *p, i = 0; i < count; i++) {
+    TAKE(1);
+    uint8_t kind = *p;
+    if (kind >= sizeof(event_addresses)) {
+      return -1;
+    }
+    TAKE(event_addresses[kind] * ADDRESS_SIZE + event_values[kind] * sizeof(uint64_t));
+  }
+  record->events = trace->data + start;
+  record->events_size = offset - start;
+
+  trace->offset = offset;
+  return 1;
+}
+
+int trace_check(trace_t *trace, host_t *host, const trace_record_t *record) {
+  abi_args_t args = record->args;
+  int64_t ret;
+  size_t first_event;
+  int status = _invoke(&trace->collector, host, record->function, record->caller, &args, &ret, &first_event);
+
+  int diverged = 0;
+  if (status != record->status || ret != record->ret) {
+    diverged |= TRACE_STATUS;
+  }
+  trace->writes.size = 0;
+  _encode_writes(&trace->collector, host, status, &trace->writes);
+  if (trace->writes.size != record->writes_size || memcmp(trace->writes.data, record->writes, record->writes_size) != 0) {
+    diverged |= TRACE_WRITES;
+  }
+  trace->events.size = 0;
+  _encode_events(host, first_event, &trace->events);
+  if (trace->events.size != record->events_size || memcmp(trace->events.data, record->events, record->events_size) != 0) {
+    diverged |= TRACE_EVENTS;
+  }
+  return diverged;
+}
+
+/**
+ * Find key in encoded writes, return its value entry (u8 size then bytes)
+ */
+static const uint8_t *_find_write(const uint8_t *writes, const uint8_t *key, size_t key_size) {
+  const uint8_t *p = writes + 1;
+  for (uint8_t i = 0; i < writes[0]; i++) {
+    const uint8_t *value = p + 1 + p[0];
+    if (p[0] == key_size && memcmp(p + 1, key, key_size) == 0) {
+      return value;
+    }
+    p = value + 1 + value[0];
+  }
+  return NULL;
+}
+
+static int _same_value(const uint8_t *a, const uint8_t *b) {
+  return a && b && a[0] == b[0] && memcmp(a + 1, b + 1, a[0]) == 0;
+}
+
+void trace_diverged_keys(const trace_t *trace, const trace_record_t *record,
+                         void (*visit)(void *ctx, const uint8_t *key, size_t key_size), void *ctx) {
+  const uint8_t *recorded = record->writes;
+  const uint8_t *replayed = trace->writes.data;
+  const uint8_t *p = recorded + 1;
+  for (uint8_t i = 0; i < recorded[0]; i++) {
+    const uint8_t *value = p + 1 + p[0];
+    if (!_same_value(value, _find_write(replayed, p + 1, p[0]))) {
+      visit(ctx, p + 1, p[0]);
+    }
+    p = value + 1 + value[0];
+  }
+  // Keys only the replay wrote
+  p = replayed + 1;
+  for (uint8_t i = 0; i < replayed[0]; i++) {
+    const uint8_t *value = p + 1 + p[0];
+    if (!_find_write(recorded, p + 1, p[0])) {
+      visit(ctx, p + 1, p[0]);
+    }
+    p = value + 1 + value[0];
+  }
+}
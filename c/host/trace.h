@@ -0,0 +1,89 @@
+//
+//  trace.h
+//  Record invocations with their storage diff and events, replay and check them
+//
+//  File layout, integers in host byte order:
+//    header  "VTRC", u32 version, u8 name size, contract name, creator
+//    record  u8 function index, u8 status, caller, one address or u64 per
+//            parameter, i64 return value,
+//            u8 write count, per key written: u8 key size, key, u8 value size,
+//            value as left by the invocation (no writes if it aborted),
+//            u8 event count, per event: u8 kind, its addresses and u64 values
+//
+
+#ifndef trace_h
+#define trace_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include "host.h"
+#include "abi.h"
+
+#define TRACE_VERSION 1
+
+typedef struct trace_writer trace_writer_t;
+typedef struct trace trace_t;
+
+typedef struct {
+  const abi_function_t *function;
+  int status;
+  int64_t ret;
+  uint8_t caller[ADDRESS_SIZE];
+  abi_args_t args;
+  // Encoded as in the file, compare with trace_check
+  const uint8_t *writes;
+  size_t writes_size;
+  const uint8_t *events;
+  size_t events_size;
+} trace_record_t;
+
+// What a replayed invocation got wrong
+#define TRACE_STATUS 1
+#define TRACE_WRITES 2
+#define TRACE_EVENTS 4
+
+/**
+ * Start a trace of contract created by creator. NULL if path cannot be opened.
+ */
+trace_writer_t *trace_create(const char *path, const abi_contract_t *contract, const uint8_t creator[ADDRESS_SIZE]);
+
+/**
+ * Invoke function on host as caller and append the invocation.
+ * Return HOST_OK or HOST_ABORTED as abi_invoke.
+ */
+int trace_call(trace_writer_t *writer, host_t *host, const abi_function_t *function,
+               const uint8_t caller[ADDRESS_SIZE], abi_args_t *args, int64_t *ret);
+
+/**
+ * Flush and close, return -1 if anything failed to write
+ */
+int trace_close(trace_writer_t *writer);
+
+/**
+ * Read a whole trace into memory, NULL if missing or not a trace
+ */
+trace_t *trace_load(const char *path);
+void trace_free(trace_t *trace);
+const abi_contract_t *trace_contract(const trace_t *trace);
+const uint8_t *trace_creator(const trace_t *trace);
+
+/**
+ * Decode the next record. Return 1, 0 at the end, -1 if the trace is corrupt.
+ */
+int trace_next(trace_t *trace, trace_record_t *record);
+void trace_rewind(trace_t *trace);
+
+/**
+ * Replay record on host and compare. Return 0 if it matches, otherwise the
+ * TRACE_* bits that differ.
+ */
+int trace_check(trace_t *trace, host_t *host, const trace_record_t *record);
+
+/**
+ * Call visit for every key whose recorded and replayed value differ in the
+ * last trace_check
+ */
+void trace_diverged_keys(const trace_t *trace, const trace_record_t *record,
+                         void (*visit)(void *ctx, const uint8_t *key, size_t key_size), void *ctx);
+
+#endif /* trace_h */
@@ -0,0 +1,407 @@
+#include "wasm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "wasm3.h"
+
+#define STACK_SIZE (64 * 1024)
+// Keys a batched storage import may take in one call
+#define MAX_BATCH 16
+
+struct wasm_module {
+  IM3Environment env;
+  IM3Runtime runtime;
+  IM3Module module;
+  uint8_t *bytes;
+  // Charged by the gas import of instrumented modules
+  uint64_t instructions;
+  int metered;
+  // Bytes of the view region taken by the current invocation
+  uint32_t view_size;
+};
+
+// Imports, pointers are checked against linear memory before use. Sizes are
+// unsigned, a negative one would slip past the check as a huge length.
+
+m3ApiRawFunction(_chain_storage_size_get) {
+  m3ApiReturnType(int32_t)
+  m3ApiGetArgMem(const void *, key)
+  m3ApiGetArg(uint32_t, key_size)
+  m3ApiCheckMem(key, key_size);
+  m3ApiReturn((int32_t)chain_storage_size_get(key, key_size));
+}
+
+m3ApiRawFunction(_chain_storage_get) {
+  m3ApiReturnType(int32_t)
+  m3ApiGetArgMem(const void *, key)
+  m3ApiGetArg(uint32_t, key_size)
+  m3ApiGetArgMem(void *, value)
+  m3ApiCheckMem(key, key_size);
+  size_t value_size;
+  host_storage_find(host_selected(), key, key_size, &value_size);
+  m3ApiCheckMem(value, value_size);
+  m3ApiReturn(chain_storage_get(key, key_size, value));
+}
+
+m3ApiRawFunction(_chain_storage_read) {
+  m3ApiReturnType(int32_t)
+  m3ApiGetArgMem(const void *, key)
+  m3ApiGetArg(uint32_t, key_size)
+  m3ApiGetArgMem(void *, value)
+  m3ApiGetArg(uint32_t, value_size)
+  m3ApiCheckMem(key, key_size);
+  m3ApiCheckMem(value, value_size);
+  m3ApiReturn((int32_t)chain_storage_read(key, key_size, value, value_size));
+}
+
+// The value is copied once into the view region, its offset is returned.
+// NULL once the region is full, value_size still receives the size.
+m3ApiRawFunction(_chain_storage_view) {
+  m3ApiReturnType(int32_t)
+  m3ApiGetArgMem(const void *, key)
+  m3ApiGetArg(uint32_t, key_size)
+  m3ApiGetArgMem(uint32_t *, value_size)
+  m3ApiCheckMem(key, key_size);
+  m3ApiCheckMem(value_size, sizeof(uint32_t));
+  wasm_module_t *module = _ctx->userdata;
+  // Memory moves when the module grows it, fetch the region every time
+  uint8_t *region = m3ApiOffsetToPtr(WASM_VIEW_OFFSET);
+  m3ApiCheckMem(region, WASM_VIEW_SIZE);
+  size_t size;
+  const void *view = chain_storage_view(key, key_size, &size);
+  *value_size = (uint32_t)size;
+  if (!view || size > WASM_VIEW_SIZE - module->view_size) {
+    m3ApiReturn(0);
+  }
+  memcpy(region + module->view_size, view, size);
+  module->view_size += (uint32_t)size;
+  m3ApiReturn((int32_t)(WASM_VIEW_OFFSET + module->view_size - size));
+}
+
+m3ApiRawFunction(_chain_emit_events) {
+  m3ApiReturnType(int32_t)
+  m3ApiGetArgMem(const void *, buffer)
+  m3ApiGetArg(uint32_t, size)
+  // Nothing past what the host takes is copied or checked
+  if (size > HOST_EVENTS_SIZE) {
+    m3ApiReturn(-1);
+  }
+  m3ApiCheckMem(buffer, size);
+  m3ApiReturn(chain_emit_events(buffer, size));
+}
+
+m3ApiRawFunction(_chain_set_return) {
+  m3ApiGetArgMem(const void *, data)
+  m3ApiGetArg(uint32_t, size)
+  m3ApiCheckMem(data, size);
+  chain_set_return(data, size);
+  m3ApiSuccess();
+}
+
+// Arrays of wasm32 pointers and sizes, translated to native ones
+m3ApiRawFunction(_chain_storage_get_many) {
+  m3ApiGetArg(int32_t, count)
+  m3ApiGetArgMem(const uint32_t *, keys)
+  m3ApiGetArgMem(const uint32_t *, key_sizes)
+  m3ApiGetArgMem(const uint32_t *, values)
+  m3ApiGetArgMem(uint32_t *, value_sizes)
+  if (count < 0 || count > MAX_BATCH) {
+    m3ApiTrap(m3Err_trapOutOfBoundsMemoryAccess);
+  }
+  m3ApiCheckMem(keys, count * sizeof(uint32_t));
+  m3ApiCheckMem(key_sizes, count * sizeof(uint32_t));
+  m3ApiCheckMem(values, count * sizeof(uint32_t));
+  m3ApiCheckMem(value_sizes, count * sizeof(uint32_t));
+  const void *native_keys[MAX_BATCH];
+  size_t native_key_sizes[MAX_BATCH];
+  void *native_values[MAX_BATCH];
+  size_t native_value_sizes[MAX_BATCH];
+  for (int32_t i = 0; i < count; i++) {
+    native_keys[i] = m3ApiOffsetToPtr(keys[i]);
+    native_key_sizes[i] = key_sizes[i];
+    native_values[i] = m3ApiOffsetToPtr(values[i]);
+    native_value_sizes[i] = value_sizes[i];
+    m3ApiCheckMem(native_keys[i], native_key_sizes[i]);
+    m3ApiCheckMem(native_values[i], native_value_sizes[i]);
+  }
+  chain_storage_get_many(count, native_keys, native_key_sizes, native_values, native_value_sizes);
+  for (int32_t i = 0; i < count; i++) {
+    value_sizes[i] = (uint32_t)native_value_sizes[i];
+  }
+  m3ApiSuccess();
+}
+
+m3ApiRawFunction(_chain_storage_set_many) {
+  m3ApiGetArg(int32_t, count)
+  m3ApiGetArgMem(const uint32_t *, keys)
+  m3ApiGetArgMem(const uint32_t *, key_sizes)
+  m3ApiGetArgMem(const uint32_t *, values)
+  m3ApiGetArgMem(const uint32_t *, value_sizes)
+  if (count < 0 || count > MAX_BATCH) {
+    m3ApiTrap(m3Err_trapOutOfBoundsMemoryAccess);
+  }
+  m3ApiCheckMem(keys, count * sizeof(uint32_t));
+  m3ApiCheckMem(key_sizes, count * sizeof(uint32_t));
+  m3ApiCheckMem(values, count * sizeof(uint32_t));
+  m3ApiCheckMem(value_sizes, count * sizeof(uint32_t));
+  const void *native_keys[MAX_BATCH];
+  size_t native_key_sizes[MAX_BATCH];
+  const void *native_values[MAX_BATCH];
+  size_t native_value_sizes[MAX_BATCH];
+  // Check everything before writing anything, a trap leaves no partial batch
+  for (int32_t i = 0; i < count; i++) {
+    native_keys[i] = m3ApiOffsetToPtr(keys[i]);
+    native_key_sizes[i] = key_sizes[i];
+    native_values[i] = m3ApiOffsetToPtr(values[i]);
+    native_value_sizes[i] = value_sizes[i];
+    m3ApiCheckMem(native_keys[i], native_key_sizes[i]);
+    m3ApiCheckMem(native_values[i], native_value_sizes[i]);
+  }
+  chain_storage_set_many(count, native_keys, native_key_sizes, native_values, native_value_sizes);
+  m3ApiSuccess();
+}
+
+m3ApiRawFunction(_chain_storage_delta_u64) {
+  m3ApiReturnType(int32_t)
+  m3ApiGetArg(int32_t, count)
+  m3ApiGetArgMem(const uint32_t *, keys)
+  m3ApiGetArgMem(const uint32_t *, key_sizes)
+  m3ApiGetArgMem(const uint64_t *, add)
+  m3ApiGetArgMem(const uint64_t *, sub)
+  if (count < 0 || count > MAX_BATCH) {
+    m3ApiReturn(-1);
+  }
+  m3ApiCheckMem(keys, count * sizeof(uint32_t));
+  m3ApiCheckMem(key_sizes, count * sizeof(uint32_t));
+  m3ApiCheckMem(add, count * sizeof(uint64_t));
+  m3ApiCheckMem(sub, count * sizeof(uint64_t));
+  const void *native_keys[MAX_BATCH];
+  size_t native_key_sizes[MAX_BATCH];
+  uint64_t native_add[MAX_BATCH];
+  uint64_t native_sub[MAX_BATCH];
+  for (int32_t i = 0; i < count; i++) {
+    native_keys[i] = m3ApiOffsetToPtr(keys[i]);
+    native_key_sizes[i] = key_sizes[i];
+    m3ApiCheckMem(native_keys[i], native_key_sizes[i]);
+    // Linear memory need not keep the arrays 8-byte aligned
+    memcpy(&native_add[i], &add[i], sizeof(uint64_t));
+    memcpy(&native_sub[i], &sub[i], sizeof(uint64_t));
+  }
+  m3ApiReturn(chain_storage_delta_u64(count, native_keys, native_key_sizes, native_add, native_sub));
+}
+
+m3ApiRawFunction(_chain_storage_set) {
+  m3ApiGetArgMem(const void *, key)
+  m3ApiGetArg(uint32_t, key_size)
+  m3ApiGetArgMem(const void *, value)
+  m3ApiGetArg(uint32_t, value_size)
+  m3ApiCheckMem(key, key_size);
+  m3ApiCheckMem(value, value_size);
+  chain_storage_set(key, key_size, value, value_size);
+  m3ApiSuccess();
+}
+
+m3ApiRawFunction(_chain_get_caller) {
+  m3ApiGetArgMem(uint8_t *, address)
+  m3ApiCheckMem(address, ADDRESS_SIZE);
+  chain_get_caller(address);
+  m3ApiSuccess();
+}
+
+m3ApiRawFunction(_chain_get_creator) {
+  m3ApiGetArgMem(uint8_t *, address)
+  m3ApiCheckMem(address, ADDRESS_SIZE);
+  chain_get_creator(address);
+  m3ApiSuccess();
+}
+
+m3ApiRawFunction(_Mint) {
+  m3ApiReturnType(int32_t)
+  m3ApiGetArgMem(const uint8_t *, to)
+  m3ApiGetArg(int64_t, amount)
+  m3ApiCheckMem(to, ADDRESS_SIZE);
+  host_emit(HOST_EVENT_MINT, to, NULL, (uint64_t)amount, 0);
+  m3ApiReturn(0);
+}
+
+m3ApiRawFunction(_Transfer) {
+  m3ApiReturnType(int32_t)
+  m3ApiGetArgMem(const uint8_t *, from)
+  m3ApiGetArgMem(const uint8_t *, to)
+  m3ApiGetArg(int64_t, amount)
+  m3ApiCheckMem(from, ADDRESS_SIZE);
+  m3ApiCheckMem(to, ADDRESS_SIZE);
+  host_emit(HOST_EVENT_TRANSFER, from, to, (uint64_t)amount, 0);
+  m3ApiReturn(0);
+}
+
+// Injected by gas metering instrumentation (wasm-instrument, pwasm-utils)
+// at the top of every metered block with its instruction count
+
+m3ApiRawFunction(_gas) {
+  m3ApiGetArg(int64_t, amount)
+  wasm_module_t *module = _ctx->userdata;
+  module->instructions += (uint64_t)amount;
+  m3ApiSuccess();
+}
+
+m3ApiRawFunction(_gas32) {
+  m3ApiGetArg(int32_t, amount)
+  wasm_module_t *module = _ctx->userdata;
+  module->instructions += (uint32_t)amount;
+  m3ApiSuccess();
+}
+
+typedef struct {
+  const char *name;
+  const char *signature;
+  M3RawCall function;
+} import_t;
+
+static const import_t imports[] = {
+  {"chain_storage_size_get", "i(*i)", _chain_storage_size_get},
+  {"chain_storage_get", "i(*i*)", _chain_storage_get},
+  {"chain_storage_read", "i(*i*i)", _chain_storage_read},
+  {"chain_storage_get_many", "v(i****)", _chain_storage_get_many},
+  {"chain_storage_set_many", "v(i****)", _chain_storage_set_many},
+  {"chain_storage_delta_u64", "i(i****)", _chain_storage_delta_u64},
+  {"chain_storage_view", "i(*i*)", _chain_storage_view},
+  {"chain_storage_set", "v(*i*i)", _chain_storage_set},
+  {"chain_get_caller", "v(*)", _chain_get_caller},
+  {"chain_get_creator", "v(*)", _chain_get_creator},
+  {"chain_emit_events", "i(*i)", _chain_emit_events},
+  {"chain_set_return", "v(*i)", _chain_set_return},
+  {"Mint", "i(*I)", _Mint},
+  {"Transfer", "i(**I)", _Transfer},
+};
+
+static wasm_module_t *_fail(wasm_module_t *module, const char *what, M3Result result) {
+  fprintf(stderr, "wasm: %s: %s\n", what, result);
+  wasm_free(module);
+  return NULL;
+}
+
+wasm_module_t *wasm_load(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    fprintf(stderr, "wasm: cannot open %s\n", path);
+    return NULL;
+  }
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  wasm_module_t *module = calloc(1, sizeof(wasm_module_t));
+  module->bytes = malloc(size);
+  if (fread(module->bytes, 1, size, file) != (size_t)size) {
+    fclose(file);
+    return _fail(module, path, "short read");
+  }
+  fclose(file);
+
+  M3Result result;
+  module->env = m3_NewEnvironment();
+  module->runtime = m3_NewRuntime(module->env, STACK_SIZE, NULL);
+  if (!module->env || !module->runtime) {
+    return _fail(module, "runtime", "out of memory");
+  }
+  if ((result = m3_ParseModule(module->env, &module->module, module->bytes, (uint32_t)size))) {
+    return _fail(module, "parse", result);
+  }
+  if ((result = m3_LoadModule(module->runtime, module->module))) {
+    // The runtime did not take ownership
+    m3_FreeModule(module->module);
+    return _fail(module, "load", result);
+  }
+  for (size_t i = 0; i < sizeof(imports) / sizeof(imports[0]); i++) {
+    result = m3_LinkRawFunctionEx(module->module, "env", imports[i].name, imports[i].signature, imports[i].function,
+                                  module);
+    // Modules need not import everything
+    if (result && result != m3Err_functionLookupFailed) {
+      return _fail(module, imports[i].name, result);
+    }
+  }
+  // Newer instrumentation passes an i64, older an i32
+  result = m3_LinkRawFunctionEx(module->module, "env", "gas", "v(I)", _gas, module);
+  if (result && result != m3Err_functionLookupFailed) {
+    result = m3_LinkRawFunctionEx(module->module, "env", "gas", "v(i)", _gas32, module);
+  }
+  module->metered = !result;
+  return module;
+}
+
+void wasm_free(wasm_module_t *module) {
+  if (!module) {
+    return;
+  }
+  if (module->runtime) {
+    m3_FreeRuntime(module->runtime);
+  }
+  if (module->env) {
+    m3_FreeEnvironment(module->env);
+  }
+  free(module->bytes);
+  free(module);
+}
+
+wasm_function_t *wasm_function(wasm_module_t *module, const char *name) {
+  IM3Function function;
+  if (m3_FindFunction(&function, module->runtime, name)) {
+    return NULL;
+  }
+  return (wasm_function_t *)function;
+}
+
+int wasm_metered(const wasm_module_t *module) {
+  return module->metered;
+}
+
+uint64_t wasm_instructions(void *module) {
+  return ((wasm_module_t *)module)->instructions;
+}
+
+uint64_t wasm_address(wasm_module_t *module, int slot, const uint8_t address[ADDRESS_SIZE]) {
+  uint32_t size;
+  // Memory moves when the module grows it, fetch it every time
+  uint8_t *memory = m3_GetMemory(module->runtime, &size, 0);
+  uint32_t offset = WASM_SCRATCH_OFFSET + slot * ADDRESS_SIZE;
+  memcpy(memory + offset, address, ADDRESS_SIZE);
+  return offset;
+}
+
+int wasm_invoke(wasm_module_t *module, host_t *host, wasm_function_t *function,
+                int argc, const uint64_t *argv, int64_t *result) {
+  IM3Function fn = (IM3Function)function;
+  union {
+    int32_t i32;
+    int64_t i64;
+  } args[WASM_MAX_ARGS];
+  const void *pointers[WASM_MAX_ARGS];
+
+  if (argc > WASM_MAX_ARGS || (uint32_t)argc != m3_GetArgCount(fn)) {
+    return HOST_ABORTED;
+  }
+  for (int i = 0; i < argc; i++) {
+    if (m3_GetArgType(fn, i) == c_m3Type_i64) {
+      args[i].i64 = (int64_t)argv[i];
+    } else {
+      args[i].i32 = (int32_t)argv[i];
+    }
+    pointers[i] = &args[i];
+  }
+
+  // Nothing longjmps to the abort point, a trap just ends the call
+  host_begin(host, m3_GetFunctionName(fn));
+  module->view_size = 0;
+  M3Result trap = m3_Call(fn, (uint32_t)argc, pointers);
+  if (!trap && result && m3_GetRetCount(fn)) {
+    union {
+      int32_t i32;
+      int64_t i64;
+    } ret;
+    const void *ret_pointers[1] = {&ret};
+    m3_GetResults(fn, 1, ret_pointers);
+    *result = m3_GetRetType(fn, 0) == c_m3Type_i64 ? ret.i64 : ret.i32;
+  }
+  return host_end(host, trap != NULL);
+}
@@ -0,0 +1,64 @@
+//
+//  wasm.h
+//  Run compiled contracts (contract.wasm) on the host emulator
+//
+//  Embeds the wasm3 interpreter, build with its sources:
+//    -I$WASM3/source $WASM3/source/*.c -lm
+//
+
+#ifndef wasm_h
+#define wasm_h
+
+#include <stdint.h>
+#include "host.h"
+
+// Address arguments are copied below the data segments, which wasm-ld
+// places at 1024 by default
+#define WASM_SCRATCH_OFFSET 256
+#define WASM_MAX_ARGS 4
+// Storage views are copied to the WASM_VIEW_SIZE bytes from here, below the
+// data too, as host storage lies outside linear memory
+#define WASM_VIEW_OFFSET 512
+#define WASM_VIEW_SIZE 512
+
+typedef struct wasm_module wasm_module_t;
+typedef struct wasm_function wasm_function_t;
+
+/**
+ * Load and instantiate a module, binding its chain_* and event imports to
+ * the host emulator. Return NULL and print the reason on failure.
+ */
+wasm_module_t *wasm_load(const char *path);
+void wasm_free(wasm_module_t *module);
+
+/**
+ * Look up an exported function, NULL if missing
+ */
+wasm_function_t *wasm_function(wasm_module_t *module, const char *name);
+
+/**
+ * Whether the module imports env.gas, i.e. was instrumented for metering
+ */
+int wasm_metered(const wasm_module_t *module);
+
+/**
+ * Instructions charged through env.gas so far, as a meter counter
+ * (pass the module as counter_ctx)
+ */
+uint64_t wasm_instructions(void *module);
+
+/**
+ * Copy an address into scratch slot (0 to WASM_MAX_ARGS - 1) of linear memory
+ * and return the pointer to pass as argument
+ */
+uint64_t wasm_address(wasm_module_t *module, int slot, const uint8_t address[ADDRESS_SIZE]);
+
+/**
+ * Invoke function on host with argc integer arguments, each converted to the
+ * parameter type. result, if not NULL, receives the first result.
+ * Return HOST_OK, or HOST_ABORTED if the module trapped.
+ */
+int wasm_invoke(wasm_module_t *module, host_t *host, wasm_function_t *function,
+                int argc, const uint64_t *argv, int64_t *result);
+
+#endif /* wasm_h */
@@ -11,13 +11,85 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #define WASI_EXPORT extern "C"
 #define ADDRESS_SIZE 35
 typedef uint8_t address_t[ADDRESS_SIZE];
 typedef int Event;
 extern size_t chain_storage_size_get(const void *, size_t);
-extern void * chain_storage_get(const void *, size_t, void *);
+extern int chain_storage_get(const void *, size_t, void *);
+// Add add[i] then subtract sub[i] from the u64 stored at each key (missing
+// is 0), all or nothing. Return 0, -1 for more than 16 keys, or 1 + the
+// index of the first key that would overflow, underflow or is not a u64.
+extern int chain_storage_delta_u64(size_t count, const void *const keys[], const size_t key_sizes[],
+                                   const uint64_t add[], const uint64_t sub[]);
 extern int chain_storage_set(const void *, size_t, const void *, size_t);
 extern void chain_get_caller(address_t);
+extern void chain_get_creator(address_t);
+// Set what the invocation returns to its caller, replacing earlier data.
+// Views return through it instead of emitting events.
+extern void chain_set_return(const void *data, size_t size);
+
+// Storage keys: a constant prefix, NUL included, then addresses. SDK_KEY
+// declares one with the prefix as its initializer, so the prefix is laid
+// down at compile time and only the addresses are copied in, once each.
+#define SDK_KEY_SIZE(prefix, addresses) (sizeof(prefix) + (addresses) * ADDRESS_SIZE)
+#define SDK_KEY(name, prefix, addresses) uint8_t name[SDK_KEY_SIZE(prefix, addresses)] = prefix
+// Copy address into slot i of a key declared with prefix
+#define SDK_KEY_SET_ADDRESS(key, prefix, i, address) \
+  memcpy((key) + sizeof(prefix) + (i) * ADDRESS_SIZE, (address), ADDRESS_SIZE)
+// Copy the prefix into a buffer of SDK_KEY_SIZE(prefix, addresses) bytes,
+// to build a key in place
+#define SDK_KEY_SET_PREFIX(key, prefix) memcpy((key), (prefix), sizeof(prefix))
+
+// Compact keys: a one-byte namespace tag, then the 32-byte payload of each
+// address, without the version byte before it and the checksum after it
+#define ADDRESS_PAYLOAD_SIZE 32
+#define SDK_COMPACT_KEY_SIZE(addresses) (1 + (addresses) * ADDRESS_PAYLOAD_SIZE)
+#define SDK_COMPACT_KEY(name, tag, addresses) uint8_t name[SDK_COMPACT_KEY_SIZE(addresses)] = {tag}
+#define SDK_COMPACT_KEY_SET_ADDRESS(key, i, address) \
+  memcpy((key) + 1 + (i) * ADDRESS_PAYLOAD_SIZE, (address) + 1, ADDRESS_PAYLOAD_SIZE)
+#define SDK_COMPACT_KEY_SET_TAG(key, tag) ((key)[0] = (tag))
+
+#ifdef __cplusplus
+// C++ builds: sdk_key<addresses>(prefix) is a constexpr key with its
+// prefix in place, and its size a constant of its type
+template <size_t PrefixSize, size_t Addresses>
+struct sdk_key_t {
+  static constexpr size_t size = PrefixSize + Addresses * ADDRESS_SIZE;
+  uint8_t bytes[size];
+
+  template <size_t I>
+  void set_address(const uint8_t *address) {
+    static_assert(I < Addresses, "no such address in this key");
+    memcpy(bytes + PrefixSize + I * ADDRESS_SIZE, address, ADDRESS_SIZE);
+  }
+};
+
+template <size_t Addresses, size_t PrefixSize>
+constexpr sdk_key_t<PrefixSize, Addresses> sdk_key(const char (&prefix)[PrefixSize]) {
+  sdk_key_t<PrefixSize, Addresses> key{};
+  for (size_t i = 0; i < PrefixSize; i++) {
+    key.bytes[i] = (uint8_t)prefix[i];
+  }
+  return key;
+}
+#endif
+
+// Access lists: the storage keys an entrypoint will touch, published ahead
+// of the call so the host can prefetch them. A pure companion
+// <entrypoint>_access(caller, arguments..., list) writes them to list, each
+// key preceded by its size in one byte, and returns the bytes used.
+#define SDK_ACCESS_SIZE 512
+
+// Append the size of a key to list and return where the key goes
+static inline uint8_t *sdk_access_key(uint8_t *list, size_t *used, size_t key_size) {
+  list[*used] = (uint8_t)key_size;
+  uint8_t *key = list + *used + 1;
+  *used += 1 + key_size;
+  return key;
+}
+
+#include "../sdk/sdk.h"
 
 #endif /* chain_h */
@@ -5,9 +5,7 @@
 #define OWNER_KEY "OWNER"
 #define NEW_OWNER_KEY "NEW_OWNER"
 #define BALANCES_PREFIX "BALANCES"
-#define BALANCES_KEY_SIZE (sizeof(BALANCES_PREFIX) + ADDRESS_SIZE)
 #define ALLOWANCES_PREFIX "ALLOWANCES"
-#define ALLOWANCES_KEY_SIZE (sizeof(ALLOWANCES_PREFIX) + ADDRESS_SIZE * 2)
 #define PAUSE_KEY "PAUSE"
 #define TOTAL_SUPPLY_KEY "TOTAL_SUPPLY"
 #define SYMBOL "QASH"
@@ -15,18 +13,86 @@
 // For mint/burn event
 const address_t ZERO_ADDRESS = {88, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 173, 17};
 
+// Legacy layout of balances and allowances: prefix, NUL, full addresses
+#define LEGACY_BALANCES_KEY_SIZE SDK_KEY_SIZE(BALANCES_PREFIX, 1)
+#define LEGACY_ALLOWANCES_KEY_SIZE SDK_KEY_SIZE(ALLOWANCES_PREFIX, 2)
+#define LEGACY_BALANCE_KEY(name, address) \
+  SDK_KEY(name, BALANCES_PREFIX, 1);      \
+  SDK_KEY_SET_ADDRESS(name, BALANCES_PREFIX, 0, address)
+#define LEGACY_ALLOWANCE_KEY(name, owner, spender)       \
+  SDK_KEY(name, ALLOWANCES_PREFIX, 2);                   \
+  SDK_KEY_SET_ADDRESS(name, ALLOWANCES_PREFIX, 0, owner); \
+  SDK_KEY_SET_ADDRESS(name, ALLOWANCES_PREFIX, 1, spender)
+// The same keys written in place, e.g. into an access list
+#define LEGACY_BALANCE_KEY_AT(key, address) \
+  SDK_KEY_SET_PREFIX(key, BALANCES_PREFIX);  \
+  SDK_KEY_SET_ADDRESS(key, BALANCES_PREFIX, 0, address)
+#define LEGACY_ALLOWANCE_KEY_AT(key, owner, spender)     \
+  SDK_KEY_SET_PREFIX(key, ALLOWANCES_PREFIX);            \
+  SDK_KEY_SET_ADDRESS(key, ALLOWANCES_PREFIX, 0, owner); \
+  SDK_KEY_SET_ADDRESS(key, ALLOWANCES_PREFIX, 1, spender)
+
+#ifdef QASH_COMPACT_KEYS
+// Compact layout: a tag and the address payloads, 33 and 65 bytes instead
+// of 44 and 81. Legacy keys are moved over before their compact key is first
+// written, see _settle, so reads fall back to the legacy key only when the
+// compact one is missing.
+#define BALANCES_TAG 1
+#define ALLOWANCES_TAG 2
+#define BALANCES_KEY_SIZE SDK_COMPACT_KEY_SIZE(1)
+#define ALLOWANCES_KEY_SIZE SDK_COMPACT_KEY_SIZE(2)
+#define BALANCE_KEY(name, address)           \
+  SDK_COMPACT_KEY(name, BALANCES_TAG, 1); \
+  SDK_COMPACT_KEY_SET_ADDRESS(name, 0, address)
+#define ALLOWANCE_KEY(name, owner, spender)  \
+  SDK_COMPACT_KEY(name, ALLOWANCES_TAG, 2); \
+  SDK_COMPACT_KEY_SET_ADDRESS(name, 0, owner); \
+  SDK_COMPACT_KEY_SET_ADDRESS(name, 1, spender)
+#define BALANCE_KEY_AT(key, address)          \
+  SDK_COMPACT_KEY_SET_TAG(key, BALANCES_TAG); \
+  SDK_COMPACT_KEY_SET_ADDRESS(key, 0, address)
+#define ALLOWANCE_KEY_AT(key, owner, spender)   \
+  SDK_COMPACT_KEY_SET_TAG(key, ALLOWANCES_TAG); \
+  SDK_COMPACT_KEY_SET_ADDRESS(key, 0, owner);   \
+  SDK_COMPACT_KEY_SET_ADDRESS(key, 1, spender)
+#else
+#define BALANCES_KEY_SIZE LEGACY_BALANCES_KEY_SIZE
+#define ALLOWANCES_KEY_SIZE LEGACY_ALLOWANCES_KEY_SIZE
+#define BALANCE_KEY LEGACY_BALANCE_KEY
+#define ALLOWANCE_KEY LEGACY_ALLOWANCE_KEY
+#define BALANCE_KEY_AT LEGACY_BALANCE_KEY_AT
+#define ALLOWANCE_KEY_AT LEGACY_ALLOWANCE_KEY_AT
+#endif
+
+#ifdef QASH_ACCOUNT_RECORDS
+#ifdef QASH_COMPACT_KEYS
+#error "QASH_ACCOUNT_RECORDS does not migrate compact keys, build with one of them"
+#endif
+// All the state of an account in one record under its balance key. The
+// balance comes first, so a read of the first 8 bytes still gets it and a
+// legacy 8-byte balance reads as a record with no nonce and no flags.
+typedef struct {
+  uint64_t balance;
+  // Transfers and burns the account made
+  uint64_t nonce;
+  // Per-account flags, none defined yet, kept as they are
+  uint32_t flags;
+  uint32_t reserved;
+} account_t;
+#endif
+
 typedef uint8_t balance_key_t[BALANCES_KEY_SIZE];
 typedef uint8_t allowance_key_t[ALLOWANCES_KEY_SIZE];
 
-// Events
-extern Event Owner(address_t owner);
-extern Event ChangeOwner(address_t old_owner, address_t new_owner);
-extern Event Mint(address_t address, uint64_t value);
-extern Event Burn(address_t address, uint64_t value);
-extern Event Transfer(address_t from, address_t to, uint64_t value, uint64_t memo);
-extern Event Approval(address_t owner, address_t spender, uint64_t value);
-extern Event Pause();
-extern Event Unpause();
+// Events, by their index in the ABI
+#define OWNER_EVENT 0
+#define CHANGE_OWNER_EVENT 1
+#define MINT_EVENT 2
+#define BURN_EVENT 3
+#define TRANSFER_EVENT 4
+#define APPROVAL_EVENT 5
+#define PAUSE_EVENT 6
+#define UNPAUSE_EVENT 7
 
 /**
  * Simple _assertion, exit on false
@@ -39,41 +105,184 @@ void _assert(int expression) {
 }
 
 /**
- * Math safe uint64 add, exit on overflow
+ * Build key of balance for storage in place, in a buffer such as an access
+ * list, and return its size. Keys of the contract's own are declared with
+ * BALANCE_KEY.
+ * Internal function
+ */
+size_t _build_balance_key(balance_key_t key, address_t address) {
+  BALANCE_KEY_AT(key, address);
+  return BALANCES_KEY_SIZE;
+}
+
+/**
+ * Build key of allowance for storage in place, in a buffer such as an access
+ * list, and return its size
+ * Internal function
+ */
+size_t _build_allowance_key(allowance_key_t key, address_t owner, address_t spender) {
+  ALLOWANCE_KEY_AT(key, owner, spender);
+  return ALLOWANCES_KEY_SIZE;
+}
+
+#ifdef QASH_COMPACT_KEYS
+/**
+ * Read the u64 at key, or at legacy_key if key is missing
+ * Internal function
+ */
+uint64_t _read_either(const uint8_t *key, size_t key_size, const uint8_t *legacy_key, size_t legacy_key_size) {
+  uint64_t value = 0;
+  if (!sdk_storage_view_u64(key, key_size, &value)) {
+    sdk_storage_view_u64(legacy_key, legacy_key_size, &value);
+  }
+  return value;
+}
+
+/**
+ * Move the u64 at legacy_key onto key, which is missing, and drop legacy_key.
+ * Return 0 if there was nothing to move.
  * Internal function
  */
-uint64_t _add(uint64_t a, uint64_t b) {
-  uint64_t c = a + b;
-  _assert(c >= a);
-  return c;
+uint8_t _migrate(const uint8_t *key, size_t key_size, const uint8_t *legacy_key, size_t legacy_key_size) {
+  uint64_t value = 0;
+  if (!chain_storage_read(legacy_key, legacy_key_size, &value, sizeof(value))) {
+    return 0;
+  }
+  const void *keys[] = {key, legacy_key};
+  const size_t key_sizes[] = {key_size, legacy_key_size};
+  const void *values[] = {&value, NULL};
+  const size_t value_sizes[] = {sizeof(value), 0};
+  chain_storage_set_many(2, keys, key_sizes, values, value_sizes);
+  return 1;
 }
 
 /**
- * Math safe uint64 add, exit on underflow
+ * Migrate the balance of address, return 0 if it had none in the legacy layout
  * Internal function
  */
-uint64_t _sub(uint64_t a, uint64_t b) {
-  _assert(b <= a);
-  return a - b;
+uint8_t _migrate_balance(address_t address) {
+  BALANCE_KEY(key, address);
+  LEGACY_BALANCE_KEY(legacy_key, address);
+  return _migrate(key, BALANCES_KEY_SIZE, legacy_key, LEGACY_BALANCES_KEY_SIZE);
 }
 
 /**
- * Build key of balance for storage
+ * Migrate an allowance, return 0 if it had none in the legacy layout
  * Internal function
  */
-void _build_balance_key(balance_key_t key, address_t address) {
-  memcpy(key, BALANCES_PREFIX, sizeof(BALANCES_PREFIX));
-  memcpy(key + sizeof(BALANCES_PREFIX), address, ADDRESS_SIZE);
+uint8_t _migrate_allowance(address_t owner, address_t spender) {
+  ALLOWANCE_KEY(key, owner, spender);
+  LEGACY_ALLOWANCE_KEY(legacy_key, owner, spender);
+  return _migrate(key, ALLOWANCES_KEY_SIZE, legacy_key, LEGACY_ALLOWANCES_KEY_SIZE);
+}
+#endif
+
+#ifdef QASH_ACCOUNT_RECORDS
+/**
+ * Move value between the records at from_key and to_key, and spend it from
+ * the allowance at allowance_key unless it is NULL. One read gets the pause
+ * flag, the records and the allowance, one write puts them back.
+ * Internal function
+ */
+void _move(uint8_t *from_key, uint8_t *to_key, uint64_t value, uint8_t *allowance_key) {
+  uint8_t flag = 0;
+  account_t records[2] = {{0}};
+  uint64_t allowance = 0;
+  const void *keys[] = {PAUSE_KEY, from_key, to_key, allowance_key};
+  const size_t key_sizes[] = {sizeof(PAUSE_KEY), BALANCES_KEY_SIZE, BALANCES_KEY_SIZE, ALLOWANCES_KEY_SIZE};
+  void *const values[] = {&flag, &records[0], &records[1], &allowance};
+  size_t value_sizes[] = {sizeof(flag), sizeof(account_t), sizeof(account_t), sizeof(allowance)};
+  size_t count = allowance_key ? 4 : 3;
+  chain_storage_get_many(count, keys, key_sizes, values, value_sizes);
+  _assert(!flag && value_sizes[1] <= sizeof(account_t) && value_sizes[2] <= sizeof(account_t));
+  _assert(records[0].balance >= value);
+  if (allowance_key) {
+    _assert((!value_sizes[3] || value_sizes[3] == sizeof(allowance)) && allowance >= value);
+  }
+
+  records[0].balance -= value;
+  records[0].nonce++;
+  // A transfer to self writes the same key twice, the last write has both changes
+  if (memcmp(from_key, to_key, BALANCES_KEY_SIZE) == 0) {
+    records[1] = records[0];
+  }
+  _assert(records[1].balance + value >= records[1].balance);
+  records[1].balance += value;
+  allowance -= value;
+
+  const void *write_keys[] = {from_key, to_key, allowance_key};
+  const size_t write_key_sizes[] = {BALANCES_KEY_SIZE, BALANCES_KEY_SIZE, ALLOWANCES_KEY_SIZE};
+  const void *write_values[] = {&records[0], &records[1], &allowance};
+  const size_t write_value_sizes[] = {sizeof(account_t), sizeof(account_t), sizeof(allowance)};
+  chain_storage_set_many(count - 1, write_keys, write_key_sizes, write_values, write_value_sizes);
 }
 
 /**
- * Build key of allowance for storage
+ * Add add to and subtract sub from both the total supply and the balance of
+ * record, as read, then write them back to key in one call. Exit on overflow
+ * or underflow.
  * Internal function
  */
-void _build_allowance_key(allowance_key_t key, address_t owner, address_t spender) {
-  memcpy(key, ALLOWANCES_PREFIX, sizeof(ALLOWANCES_PREFIX));
-  memcpy(key + sizeof(ALLOWANCES_PREFIX), owner, ADDRESS_SIZE);
-  memcpy(key + sizeof(ALLOWANCES_PREFIX) + ADDRESS_SIZE, spender, ADDRESS_SIZE);
+void _write_supply(uint8_t *key, account_t *record, uint64_t total_supply, uint64_t add, uint64_t sub) {
+  _assert(total_supply + add >= total_supply && total_supply + add >= sub);
+  _assert(record->balance + add >= record->balance && record->balance + add >= sub);
+  total_supply = total_supply + add - sub;
+  record->balance = record->balance + add - sub;
+  const void *keys[] = {TOTAL_SUPPLY_KEY, key};
+  const size_t key_sizes[] = {sizeof(TOTAL_SUPPLY_KEY), BALANCES_KEY_SIZE};
+  const void *values[] = {&total_supply, record};
+  const size_t value_sizes[] = {sizeof(total_supply), sizeof(account_t)};
+  chain_storage_set_many(2, keys, key_sizes, values, value_sizes);
+}
+#endif
+
+// Events are buffered, every entrypoint that emits flushes them before returning
+
+Event Owner(const address_t owner) {
+  const uint8_t *addresses[] = {owner};
+  sdk_event(OWNER_EVENT, addresses, 1, NULL, 0);
+  return 0;
+}
+
+Event ChangeOwner(const address_t old_owner, const address_t new_owner) {
+  const uint8_t *addresses[] = {old_owner, new_owner};
+  sdk_event(CHANGE_OWNER_EVENT, addresses, 2, NULL, 0);
+  return 0;
+}
+
+Event Mint(const address_t address, uint64_t value) {
+  const uint8_t *addresses[] = {address};
+  sdk_event(MINT_EVENT, addresses, 1, &value, 1);
+  return 0;
+}
+
+Event Burn(const address_t address, uint64_t value) {
+  const uint8_t *addresses[] = {address};
+  sdk_event(BURN_EVENT, addresses, 1, &value, 1);
+  return 0;
+}
+
+Event Transfer(const address_t from, const address_t to, uint64_t value, uint64_t memo) {
+  const uint8_t *addresses[] = {from, to};
+  const uint64_t values[] = {value, memo};
+  sdk_event(TRANSFER_EVENT, addresses, 2, values, 2);
+  return 0;
+}
+
+Event Approval(const address_t owner, const address_t spender, uint64_t value) {
+  const uint8_t *addresses[] = {owner, spender};
+  sdk_event(APPROVAL_EVENT, addresses, 2, &value, 1);
+  return 0;
+}
+
+Event Pause() {
+  sdk_event(PAUSE_EVENT, NULL, 0, NULL, 0);
+  return 0;
+}
+
+Event Unpause() {
+  sdk_event(UNPAUSE_EVENT, NULL, 0, NULL, 0);
+  return 0;
 }
 
 // Functions
@@ -84,34 +293,42 @@ void _build_allowance_key(allowance_key_t key, address_t owner, address_t spende
  * - Lock init
  */
 void init(void) {
+  sdk_context_begin();
   // Not init yet
-  _assert(!chain_storage_size_get(OWNER_KEY, sizeof(OWNER_KEY)));
-  address_t owner;
-  chain_get_caller(owner);
+  _assert(!sdk_owner(OWNER_KEY, sizeof(OWNER_KEY)));
   // Init
-  chain_storage_set(OWNER_KEY, sizeof(OWNER_KEY), owner, ADDRESS_SIZE);
+  sdk_set_owner(OWNER_KEY, sizeof(OWNER_KEY), sdk_caller());
   // Emit event set owner
-  Owner(owner);
+  Owner(sdk_caller());
+  sdk_events_flush();
 }
 
 /**
- * Return owner address via Owner event
+ * Return owner address as return data, none before init
  */
 void get_owner(void) {
-  address_t owner;
-  chain_storage_get(OWNER_KEY, sizeof(OWNER_KEY), owner);
-  Owner(owner);
+  sdk_context_begin();
+  uint8_t *owner = sdk_owner(OWNER_KEY, sizeof(OWNER_KEY));
+  if (owner) {
+    chain_set_return(owner, ADDRESS_SIZE);
+  }
+}
+
+/**
+ * Check if caller is owner
+ * Internal function
+ */
+uint8_t _is_owner(void) {
+  uint8_t *owner = sdk_owner(OWNER_KEY, sizeof(OWNER_KEY));
+  return owner && memcmp(owner, sdk_caller(), ADDRESS_SIZE) == 0;
 }
 
 /**
  * Check if caller is owner
  */
 uint8_t is_owner(void) {
-  address_t caller;
-  address_t owner;
-  chain_get_caller(caller);
-  chain_storage_get(OWNER_KEY, sizeof(OWNER_KEY), owner);
-  return memcmp(owner, caller, ADDRESS_SIZE) == 0;
+  sdk_context_begin();
+  return _is_owner();
 }
 
 /**
@@ -119,24 +336,29 @@ uint8_t is_owner(void) {
  * Require caller is current owner
  */
 void propose_new_owner(address_t new_owner) {
-  _assert(is_owner());
-  address_t owner;
-  chain_storage_get(OWNER_KEY, sizeof(OWNER_KEY), owner);
+  sdk_context_begin();
+  _assert(_is_owner());
   chain_storage_set(NEW_OWNER_KEY, sizeof(NEW_OWNER_KEY), new_owner, ADDRESS_SIZE);
 }
 
+/**
+ * Check if caller is candidate owner, leave the candidate in new_owner
+ * Internal function
+ */
+uint8_t _is_new_owner(address_t new_owner) {
+  if (chain_storage_read(NEW_OWNER_KEY, sizeof(NEW_OWNER_KEY), new_owner, ADDRESS_SIZE)) {
+    return memcmp(new_owner, sdk_caller(), ADDRESS_SIZE) == 0;
+  }
+  return 0;
+}
+
 /**
  * Check if caller is candidate owner
  */
 uint8_t is_new_owner(void) {
-  address_t caller;
+  sdk_context_begin();
   address_t new_owner;
-  chain_get_caller(caller);
-  if (chain_storage_size_get(NEW_OWNER_KEY, sizeof(NEW_OWNER_KEY))) {
-    chain_storage_get(NEW_OWNER_KEY, sizeof(NEW_OWNER_KEY), new_owner);
-    return memcmp(new_owner, caller, ADDRESS_SIZE) == 0;
-  }
-  return 0;
+  return _is_new_owner(new_owner);
 }
 
 /**
@@ -144,48 +366,64 @@ uint8_t is_new_owner(void) {
  * Require caller is current owner
  */
 void claim_ownership(void) {
-  _assert(is_new_owner());
+  sdk_context_begin();
   address_t owner, new_owner;
-  chain_storage_get(OWNER_KEY, sizeof(OWNER_KEY), owner);
-  chain_storage_get(NEW_OWNER_KEY, sizeof(NEW_OWNER_KEY), new_owner);
+  _assert(_is_new_owner(new_owner));
+  uint8_t *current = sdk_owner(OWNER_KEY, sizeof(OWNER_KEY));
+  _assert(current != NULL);
+  memcpy(owner, current, ADDRESS_SIZE);
   chain_storage_set(NEW_OWNER_KEY, sizeof(NEW_OWNER_KEY), NULL, 0);
-  chain_storage_set(OWNER_KEY, sizeof(OWNER_KEY), new_owner, ADDRESS_SIZE);
+  sdk_set_owner(OWNER_KEY, sizeof(OWNER_KEY), new_owner);
   ChangeOwner(owner, new_owner);
+  sdk_events_flush();
 }
 
 /**
  * Return the balance of an address. If address does not exist, return 0
  */
 uint64_t get_balance(address_t address) {
-  balance_key_t key;
-  _build_balance_key(key, address);
+  BALANCE_KEY(key, address);
+#ifdef QASH_COMPACT_KEYS
+  LEGACY_BALANCE_KEY(legacy_key, address);
+  uint64_t balance = _read_either(key, BALANCES_KEY_SIZE, legacy_key, LEGACY_BALANCES_KEY_SIZE);
+#else
   uint64_t balance = 0;
-  if (chain_storage_size_get(key, BALANCES_KEY_SIZE)) {
-    chain_storage_get(key, BALANCES_KEY_SIZE, &balance); 
-  }
+  sdk_storage_view_u64(key, BALANCES_KEY_SIZE, &balance);
+#endif
+  chain_set_return(&balance, sizeof(balance));
   return balance;
 }
 
 /**
- * Check if transfer is paused
+ * Check if transfer is paused, through the write-back cache
+ * Internal function
  */
-uint8_t is_paused(void) {
+uint8_t _is_paused(void) {
   uint8_t flag = 0;
-  if (chain_storage_size_get(PAUSE_KEY, sizeof(PAUSE_KEY))) {
-    chain_storage_get(PAUSE_KEY, sizeof(PAUSE_KEY), &flag);
-  }
+  sdk_cache_read(PAUSE_KEY, sizeof(PAUSE_KEY), &flag, sizeof(flag));
   return flag;
 }
 
+/**
+ * Check if transfer is paused
+ */
+uint8_t is_paused(void) {
+  sdk_context_begin();
+  return _is_paused();
+}
+
 /**
  * Pause the token transfer
  * Require caller is owner
  */
 void pause(void) {
-  _assert(is_owner() && !is_paused());
+  sdk_context_begin();
+  _assert(_is_owner() && !_is_paused());
   uint8_t flag = 1;
-  chain_storage_set(PAUSE_KEY, sizeof(PAUSE_KEY), &flag, sizeof(flag));
+  sdk_cache_set(PAUSE_KEY, sizeof(PAUSE_KEY), &flag, sizeof(flag));
+  sdk_cache_commit();
   Pause();
+  sdk_events_flush();
 }
 
 /**
@@ -193,32 +431,78 @@ void pause(void) {
  * Require caller is owner
  */
 void unpause(void) {
-  _assert(is_owner() && is_paused());
+  sdk_context_begin();
+  _assert(_is_owner() && _is_paused());
   uint8_t flag = 0;
-  chain_storage_set(PAUSE_KEY, sizeof(PAUSE_KEY), &flag, sizeof(flag));
+  sdk_cache_set(PAUSE_KEY, sizeof(PAUSE_KEY), &flag, sizeof(flag));
+  sdk_cache_commit();
   Unpause();
+  sdk_events_flush();
 }
 
+#ifdef QASH_COMPACT_KEYS
 /**
- * Internal transfer function
+ * Read the pause flag into the cache along with the balances of from and to,
+ * at from_key and to_key, and the allowance from gave spender at
+ * allowance_key, and migrate those still missing. to_key and allowance_key
+ * may be NULL to leave them out. One host call when all exist already.
+ * Internal function
  */
-void _transfer(address_t from, address_t to, uint64_t value, uint64_t memo) {
-  _assert(!is_paused() && memcmp(to, ZERO_ADDRESS, ADDRESS_SIZE) != 0);
-
-  // Get current balance
-  uint64_t from_balance = get_balance(from);
-  uint64_t to_balance = get_balance(to);
-
-  // Safe math will exit if not enough balance
-  from_balance = _sub(from_balance, value);
-  to_balance = _add(to_balance, value);
+void _settle(uint8_t *from_key, address_t from, uint8_t *to_key, address_t to, uint8_t *allowance_key,
+             address_t spender) {
+  uint8_t flag = 0;
+  const void *keys[] = {PAUSE_KEY, from_key, to_key, allowance_key};
+  const size_t key_sizes[] = {sizeof(PAUSE_KEY), BALANCES_KEY_SIZE, BALANCES_KEY_SIZE, ALLOWANCES_KEY_SIZE};
+  void *const values[] = {&flag, NULL, NULL, NULL};
+  size_t value_sizes[] = {sizeof(flag), 0, 0, 0};
+  size_t count = allowance_key ? 4 : to_key ? 3 : 2;
+  chain_storage_get_many(count, keys, key_sizes, values, value_sizes);
+  if (value_sizes[0] <= sizeof(flag)) {
+    sdk_cache_fill(PAUSE_KEY, sizeof(PAUSE_KEY), &flag, value_sizes[0]);
+  }
+  _assert(!_is_paused());
+  if (!value_sizes[1]) {
+    _migrate_balance(from);
+  }
+  if (count > 2 && !value_sizes[2]) {
+    _migrate_balance(to);
+  }
+  if (count > 3 && !value_sizes[3]) {
+    _migrate_allowance(from, spender);
+  }
+}
+#endif
 
-  // Update storage
-  balance_key_t from_balance_key, to_balance_key;
-  _build_balance_key(from_balance_key, from);
-  _build_balance_key(to_balance_key, to);
-  chain_storage_set(from_balance_key, BALANCES_KEY_SIZE, &from_balance, sizeof(from_balance));
-  chain_storage_set(to_balance_key, BALANCES_KEY_SIZE, &to_balance, sizeof(to_balance));
+/**
+ * Internal transfer function
+ * Spend the allowance stored at allowance_key too, unless it is NULL.
+ * Balances and allowance are updated in place by the host, in one call.
+ */
+void _transfer(address_t from, address_t to, uint64_t value, uint64_t memo, uint8_t *allowance_key) {
+  BALANCE_KEY(from_balance_key, from);
+  BALANCE_KEY(to_balance_key, to);
+
+#ifdef QASH_ACCOUNT_RECORDS
+  // The pause flag is read along with the records
+  _assert(memcmp(to, ZERO_ADDRESS, ADDRESS_SIZE) != 0);
+  _move(from_balance_key, to_balance_key, value, allowance_key);
+#else
+#ifdef QASH_COMPACT_KEYS
+  // The pause flag is read along with the compact keys
+  _assert(memcmp(to, ZERO_ADDRESS, ADDRESS_SIZE) != 0);
+  _settle(from_balance_key, from, to_balance_key, to, allowance_key, allowance_key ? sdk_caller() : NULL);
+#else
+  _assert(!_is_paused() && memcmp(to, ZERO_ADDRESS, ADDRESS_SIZE) != 0);
+#endif
+
+  // Checked by the host, exit if not enough balance or allowance
+  const void *keys[] = {from_balance_key, to_balance_key, allowance_key};
+  const size_t key_sizes[] = {BALANCES_KEY_SIZE, BALANCES_KEY_SIZE, ALLOWANCES_KEY_SIZE};
+  const uint64_t add[] = {0, value, 0};
+  const uint64_t sub[] = {value, 0, value};
+  size_t count = allowance_key ? 3 : 2;
+  _assert(!chain_storage_delta_u64(count, keys, key_sizes, add, sub));
+#endif
 
   Transfer(from, to, value, memo);
 }
@@ -227,22 +511,24 @@ void _transfer(address_t from, address_t to, uint64_t value, uint64_t memo) {
  * Transfer tokens from caller to another address with a memo
  */
 void transfer(address_t to, uint64_t value, uint64_t memo) { 
-  address_t from;
-  chain_get_caller(from);
-
-  _transfer(from, to, value, memo);
+  sdk_context_begin();
+  _transfer(sdk_caller(), to, value, memo, NULL);
+  sdk_events_flush();
 }
 
 /**
  * Return current allowance that an token holder allows spender to transfer
  */
 uint64_t get_allowance(address_t owner, address_t spender) {
-  allowance_key_t key;
-  _build_allowance_key(key, owner, spender);
+  ALLOWANCE_KEY(key, owner, spender);
+#ifdef QASH_COMPACT_KEYS
+  LEGACY_ALLOWANCE_KEY(legacy_key, owner, spender);
+  uint64_t value = _read_either(key, ALLOWANCES_KEY_SIZE, legacy_key, LEGACY_ALLOWANCES_KEY_SIZE);
+#else
   uint64_t value = 0;
-  if (chain_storage_size_get(key, ALLOWANCES_KEY_SIZE)) {
-    chain_storage_get(key, ALLOWANCES_KEY_SIZE, &value); 
-  }
+  sdk_storage_view_u64(key, ALLOWANCES_KEY_SIZE, &value);
+#endif
+  chain_set_return(&value, sizeof(value));
   return value;
 }
 
@@ -250,12 +536,27 @@ uint64_t get_allowance(address_t owner, address_t spender) {
  * Approve a spender to transfer tokens on behalf of a token holder
  */
 void approve(address_t spender, uint64_t value) {
-  address_t owner;
-  chain_get_caller(owner);
-  allowance_key_t key;
-  _build_allowance_key(key, owner, spender);
+  sdk_context_begin();
+  uint8_t *owner = sdk_caller();
+  ALLOWANCE_KEY(key, owner, spender);
+#ifdef QASH_COMPACT_KEYS
+  // The new allowance replaces any legacy one, which is dropped only if it
+  // exists so approvals leave no empty keys behind
+  LEGACY_ALLOWANCE_KEY(legacy_key, owner, spender);
+  if (chain_storage_read(legacy_key, LEGACY_ALLOWANCES_KEY_SIZE, NULL, 0)) {
+    const void *keys[] = {key, legacy_key};
+    const size_t key_sizes[] = {ALLOWANCES_KEY_SIZE, LEGACY_ALLOWANCES_KEY_SIZE};
+    const void *values[] = {&value, NULL};
+    const size_t value_sizes[] = {sizeof(value), 0};
+    chain_storage_set_many(2, keys, key_sizes, values, value_sizes);
+  } else {
+    chain_storage_set(key, ALLOWANCES_KEY_SIZE, &value, sizeof(value));
+  }
+#else
   chain_storage_set(key, ALLOWANCES_KEY_SIZE, &value, sizeof(value));
+#endif
   Approval(owner, spender, value);
+  sdk_events_flush();
 }
 
 /**
@@ -263,19 +564,11 @@ void approve(address_t spender, uint64_t value) {
  * The amount must not greater than the allowance was set by `approve`
  */
 void transfer_from(address_t from, address_t to, uint64_t value, uint64_t memo) {
-  address_t spender;
-  chain_get_caller(spender);
-
-  // Check allowance
-  uint64_t allowance = get_allowance(from, spender);
-  allowance = _sub(allowance, value);
-
-  // Update storage
-  allowance_key_t key;
-  _build_allowance_key(key, from, spender);
-  chain_storage_set(key, ALLOWANCES_KEY_SIZE, &allowance, sizeof(allowance));
-  
-  _transfer(from, to, value, memo);
+  sdk_context_begin();
+  // Allowance is checked and spent along with the balances
+  ALLOWANCE_KEY(key, from, sdk_caller());
+  _transfer(from, to, value, memo, key);
+  sdk_events_flush();
 }
 
 /**
@@ -297,9 +590,7 @@ uint64_t get_symbol(void) {
  */
 uint64_t get_total_supply(void) {
   uint64_t total_supply = 0;
-  if (chain_storage_size_get(TOTAL_SUPPLY_KEY, sizeof(TOTAL_SUPPLY_KEY))) {
-    chain_storage_get(TOTAL_SUPPLY_KEY, sizeof(TOTAL_SUPPLY_KEY), &total_supply);
-  }
+  chain_storage_read(TOTAL_SUPPLY_KEY, sizeof(TOTAL_SUPPLY_KEY), &total_supply, sizeof(total_supply));
   return total_supply;
 }
 
@@ -308,19 +599,62 @@ uint64_t get_total_supply(void) {
  * Require caller is owner
  */
 void mint(address_t to, uint64_t value) {
-  _assert(is_owner() && !is_paused() && memcmp(to, ZERO_ADDRESS, ADDRESS_SIZE) != 0);
-  uint64_t total_supply = get_total_supply();
-  uint64_t to_balance = get_balance(to);
-  total_supply = _add(total_supply, value);
-  to_balance = _add(to_balance, value);
-  // Update total supply
-  chain_storage_set(TOTAL_SUPPLY_KEY, sizeof(TOTAL_SUPPLY_KEY), &total_supply, sizeof(total_supply));
-  // Update balance
-  balance_key_t key;
-  _build_balance_key(key, to);
-  chain_storage_set(key, BALANCES_KEY_SIZE, &to_balance, sizeof(to_balance));
+  sdk_context_begin();
+  BALANCE_KEY(key, to);
+#ifdef QASH_ACCOUNT_RECORDS
+  // Owner, pause flag, total supply and the record of to in one host call,
+  // the flag goes to the cache
+  uint8_t flag = 0;
+  uint64_t total_supply = 0;
+  account_t record = {0};
+  const void *keys[] = {OWNER_KEY, PAUSE_KEY, TOTAL_SUPPLY_KEY, key};
+  const size_t key_sizes[] = {sizeof(OWNER_KEY), sizeof(PAUSE_KEY), sizeof(TOTAL_SUPPLY_KEY), BALANCES_KEY_SIZE};
+  void *const values[] = {sdk_context.owner, &flag, &total_supply, &record};
+  size_t value_sizes[] = {ADDRESS_SIZE, sizeof(flag), sizeof(total_supply), sizeof(record)};
+  chain_storage_get_many(4, keys, key_sizes, values, value_sizes);
+  sdk_owner_fetched(value_sizes[0]);
+  if (value_sizes[1] <= sizeof(flag)) {
+    sdk_cache_fill(PAUSE_KEY, sizeof(PAUSE_KEY), &flag, value_sizes[1]);
+  }
+  _assert(_is_owner());
+  _assert(!_is_paused() && memcmp(to, ZERO_ADDRESS, ADDRESS_SIZE) != 0 && value_sizes[3] <= sizeof(record));
+  _write_supply(key, &record, total_supply, value, 0);
+#else
+  // Get owner and pause flag in one host call, the owner goes to the context
+  // and the flag to the cache. With compact keys, also whether the balance of
+  // to exists yet
+  uint8_t flag = 0;
+  const void *keys[] = {OWNER_KEY, PAUSE_KEY, key};
+  const size_t key_sizes[] = {sizeof(OWNER_KEY), sizeof(PAUSE_KEY), BALANCES_KEY_SIZE};
+  void *const values[] = {sdk_context.owner, &flag, NULL};
+  size_t value_sizes[] = {ADDRESS_SIZE, sizeof(flag), 0};
+#ifdef QASH_COMPACT_KEYS
+  chain_storage_get_many(3, keys, key_sizes, values, value_sizes);
+#else
+  chain_storage_get_many(2, keys, key_sizes, values, value_sizes);
+#endif
+  sdk_owner_fetched(value_sizes[0]);
+  if (value_sizes[1] <= sizeof(flag)) {
+    sdk_cache_fill(PAUSE_KEY, sizeof(PAUSE_KEY), &flag, value_sizes[1]);
+  }
+  _assert(_is_owner());
+  _assert(!_is_paused() && memcmp(to, ZERO_ADDRESS, ADDRESS_SIZE) != 0);
+#ifdef QASH_COMPACT_KEYS
+  if (!value_sizes[2]) {
+    _migrate_balance(to);
+  }
+#endif
+
+  // Update total supply and balance in place, exit on overflow
+  const void *delta_keys[] = {TOTAL_SUPPLY_KEY, key};
+  const size_t delta_key_sizes[] = {sizeof(TOTAL_SUPPLY_KEY), BALANCES_KEY_SIZE};
+  const uint64_t add[] = {value, value};
+  const uint64_t sub[] = {0, 0};
+  _assert(!chain_storage_delta_u64(2, delta_keys, delta_key_sizes, add, sub));
+#endif
   Mint(to, value);
   Transfer(ZERO_ADDRESS, to, value, 0);
+  sdk_events_flush();
 }
 
 /**
@@ -328,19 +662,151 @@ void mint(address_t to, uint64_t value) {
  */
 void burn(uint64_t value)
 {
-  _assert(!is_paused());
-  address_t caller;
-  chain_get_caller(caller);
-  uint64_t total_supply = get_total_supply();
-  uint64_t caller_balance = get_balance(caller);
-  total_supply = _sub(total_supply, value);
-  caller_balance = _sub(caller_balance, value);
-  // Update total supply
-  chain_storage_set(TOTAL_SUPPLY_KEY, sizeof(TOTAL_SUPPLY_KEY), &total_supply, sizeof(total_supply));
-  // Update balance
-  balance_key_t key;
-  _build_balance_key(key, caller);
-  chain_storage_set(key, BALANCES_KEY_SIZE, &caller_balance, sizeof(caller_balance));
+  sdk_context_begin();
+  uint8_t *caller = sdk_caller();
+  BALANCE_KEY(key, caller);
+#ifdef QASH_ACCOUNT_RECORDS
+  // Pause flag, total supply and the record of caller in one host call
+  uint8_t flag = 0;
+  uint64_t total_supply = 0;
+  account_t record = {0};
+  const void *keys[] = {PAUSE_KEY, TOTAL_SUPPLY_KEY, key};
+  const size_t key_sizes[] = {sizeof(PAUSE_KEY), sizeof(TOTAL_SUPPLY_KEY), BALANCES_KEY_SIZE};
+  void *const values[] = {&flag, &total_supply, &record};
+  size_t value_sizes[] = {sizeof(flag), sizeof(total_supply), sizeof(record)};
+  chain_storage_get_many(3, keys, key_sizes, values, value_sizes);
+  _assert(!flag && value_sizes[2] <= sizeof(record));
+  record.nonce++;
+  _write_supply(key, &record, total_supply, 0, value);
+#else
+#ifdef QASH_COMPACT_KEYS
+  _settle(key, caller, NULL, NULL, NULL, NULL);
+#else
+  _assert(!_is_paused());
+#endif
+  // Update total supply and balance in place, exit on underflow
+  const void *keys[] = {TOTAL_SUPPLY_KEY, key};
+  const size_t key_sizes[] = {sizeof(TOTAL_SUPPLY_KEY), BALANCES_KEY_SIZE};
+  const uint64_t add[] = {0, 0};
+  const uint64_t sub[] = {value, value};
+  _assert(!chain_storage_delta_u64(2, keys, key_sizes, add, sub));
+#endif
   Burn(caller, value);
   Transfer(caller, ZERO_ADDRESS, value, 0);
+  sdk_events_flush();
+}
+
+// Access lists
+
+#ifdef QASH_COMPACT_KEYS
+/**
+ * Legacy keys a transfer may migrate: the balances of from and to, unless
+ * to is NULL, and the allowance from gave spender unless spender is NULL
+ * Internal function
+ */
+void _legacy_access(address_t from, address_t to, address_t spender, uint8_t *list, size_t *size) {
+  uint8_t *balance_key = sdk_access_key(list, size, LEGACY_BALANCES_KEY_SIZE);
+  LEGACY_BALANCE_KEY_AT(balance_key, from);
+  if (to) {
+    balance_key = sdk_access_key(list, size, LEGACY_BALANCES_KEY_SIZE);
+    LEGACY_BALANCE_KEY_AT(balance_key, to);
+  }
+  if (spender) {
+    uint8_t *allowance_key = sdk_access_key(list, size, LEGACY_ALLOWANCES_KEY_SIZE);
+    LEGACY_ALLOWANCE_KEY_AT(allowance_key, from, spender);
+  }
+}
+#endif
+
+/**
+ * Keys of pause and unpause
+ */
+size_t pause_access(address_t caller, uint8_t list[SDK_ACCESS_SIZE]) {
+  (void)caller;
+  size_t size = 0;
+  memcpy(sdk_access_key(list, &size, sizeof(OWNER_KEY)), OWNER_KEY, sizeof(OWNER_KEY));
+  memcpy(sdk_access_key(list, &size, sizeof(PAUSE_KEY)), PAUSE_KEY, sizeof(PAUSE_KEY));
+  return size;
+}
+
+size_t unpause_access(address_t caller, uint8_t list[SDK_ACCESS_SIZE]) {
+  return pause_access(caller, list);
+}
+
+/**
+ * Keys of transfer: pause flag and both balances
+ */
+size_t transfer_access(address_t caller, address_t to, uint64_t value, uint64_t memo, uint8_t list[SDK_ACCESS_SIZE]) {
+  (void)value;
+  (void)memo;
+  size_t size = 0;
+  memcpy(sdk_access_key(list, &size, sizeof(PAUSE_KEY)), PAUSE_KEY, sizeof(PAUSE_KEY));
+  _build_balance_key(sdk_access_key(list, &size, BALANCES_KEY_SIZE), caller);
+  _build_balance_key(sdk_access_key(list, &size, BALANCES_KEY_SIZE), to);
+#ifdef QASH_COMPACT_KEYS
+  _legacy_access(caller, to, NULL, list, &size);
+#endif
+  return size;
+}
+
+/**
+ * Keys of approve: the allowance
+ */
+size_t approve_access(address_t caller, address_t spender, uint64_t value, uint8_t list[SDK_ACCESS_SIZE]) {
+  (void)value;
+  size_t size = 0;
+  _build_allowance_key(sdk_access_key(list, &size, ALLOWANCES_KEY_SIZE), caller, spender);
+#ifdef QASH_COMPACT_KEYS
+  uint8_t *legacy_key = sdk_access_key(list, &size, LEGACY_ALLOWANCES_KEY_SIZE);
+  LEGACY_ALLOWANCE_KEY_AT(legacy_key, caller, spender);
+#endif
+  return size;
+}
+
+/**
+ * Keys of transfer_from: pause flag, both balances and the allowance
+ */
+size_t transfer_from_access(address_t caller, address_t from, address_t to, uint64_t value, uint64_t memo,
+                            uint8_t list[SDK_ACCESS_SIZE]) {
+  (void)value;
+  (void)memo;
+  size_t size = 0;
+  memcpy(sdk_access_key(list, &size, sizeof(PAUSE_KEY)), PAUSE_KEY, sizeof(PAUSE_KEY));
+  _build_balance_key(sdk_access_key(list, &size, BALANCES_KEY_SIZE), from);
+  _build_balance_key(sdk_access_key(list, &size, BALANCES_KEY_SIZE), to);
+  _build_allowance_key(sdk_access_key(list, &size, ALLOWANCES_KEY_SIZE), from, caller);
+#ifdef QASH_COMPACT_KEYS
+  _legacy_access(from, to, caller, list, &size);
+#endif
+  return size;
+}
+
+/**
+ * Keys of mint: owner, pause flag, total supply and the balance minted to
+ */
+size_t mint_access(address_t caller, address_t to, uint64_t value, uint8_t list[SDK_ACCESS_SIZE]) {
+  (void)value;
+  size_t size = pause_access(caller, list);
+  memcpy(sdk_access_key(list, &size, sizeof(TOTAL_SUPPLY_KEY)), TOTAL_SUPPLY_KEY, sizeof(TOTAL_SUPPLY_KEY));
+  _build_balance_key(sdk_access_key(list, &size, BALANCES_KEY_SIZE), to);
+#ifdef QASH_COMPACT_KEYS
+  uint8_t *legacy_key = sdk_access_key(list, &size, LEGACY_BALANCES_KEY_SIZE);
+  LEGACY_BALANCE_KEY_AT(legacy_key, to);
+#endif
+  return size;
+}
+
+/**
+ * Keys of burn: pause flag, total supply and the balance of caller
+ */
+size_t burn_access(address_t caller, uint64_t value, uint8_t list[SDK_ACCESS_SIZE]) {
+  (void)value;
+  size_t size = 0;
+  memcpy(sdk_access_key(list, &size, sizeof(PAUSE_KEY)), PAUSE_KEY, sizeof(PAUSE_KEY));
+  memcpy(sdk_access_key(list, &size, sizeof(TOTAL_SUPPLY_KEY)), TOTAL_SUPPLY_KEY, sizeof(TOTAL_SUPPLY_KEY));
+  _build_balance_key(sdk_access_key(list, &size, BALANCES_KEY_SIZE), caller);
+#ifdef QASH_COMPACT_KEYS
+  _legacy_access(caller, NULL, NULL, list, &size);
+#endif
+  return size;
 }
@@ -0,0 +1,369 @@
+//
+//  sdk.h
+//  Contract-side SDK shared by qash, token and erc20
+//
+//  Include it after the chain header of the contract, which declares
+//  chain_storage_set, chain_get_caller and chain_get_creator. The imports
+//  added since are declared here.
+//
+
+#ifndef sdk_h
+#define sdk_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef ADDRESS_SIZE
+#define ADDRESS_SIZE 35
+#endif
+
+// Copy up to value_size bytes of the value, return its full size (0 if missing)
+extern size_t chain_storage_read(const void *key, size_t key_size, void *value, size_t value_size);
+// Read count keys in one call, value_sizes go in as buffer sizes and come
+// back as the full sizes (0 if missing)
+extern void chain_storage_get_many(size_t count, const void *const keys[], const size_t key_sizes[],
+                                   void *const values[], size_t value_sizes[]);
+// Write count keys in one call, as a single batch
+extern void chain_storage_set_many(size_t count, const void *const keys[], const size_t key_sizes[],
+                                   const void *const values[], const size_t value_sizes[]);
+// Read-only view of the value, NULL if missing, value_size receives its size.
+// Valid until the key is written or the invocation returns. Natively it points
+// into host storage; under wasm the host copies the value once into a 512-byte
+// region of linear memory, and returns NULL with the size set once it is full.
+extern const void *chain_storage_view(const void *key, size_t key_size, size_t *value_size);
+// Append the events encoded in buffer to the log, all or nothing. Return 0,
+// or -1 if an event is unknown or truncated, or size is over 1024 bytes.
+extern int chain_emit_events(const void *buffer, size_t size);
+
+// Typed storage reads into a stack buffer, no heap involved. Values are
+// little endian, shorter ones are zero-extended and longer ones truncated.
+
+// The u64 stored at key, def if it is missing
+static inline uint64_t sdk_storage_get_u64(const void *key, size_t key_size, uint64_t def) {
+  uint64_t value = 0;
+  return chain_storage_read(key, key_size, &value, sizeof(value)) ? value : def;
+}
+
+// The flag stored at key, 0 if it is missing
+static inline uint8_t sdk_storage_get_flag(const void *key, size_t key_size) {
+  uint8_t flag = 0;
+  chain_storage_read(key, key_size, &flag, sizeof(flag));
+  return flag;
+}
+
+// Copy the address stored at key to out and return 1, or return 0 and zero
+// out if there is no full address
+static inline int sdk_storage_get_address(const void *key, size_t key_size, uint8_t out[ADDRESS_SIZE]) {
+  if (chain_storage_read(key, key_size, out, ADDRESS_SIZE) == ADDRESS_SIZE) {
+    return 1;
+  }
+  memset(out, 0, ADDRESS_SIZE);
+  return 0;
+}
+
+// Read the u64 at key into value through a view, so only its first bytes are
+// decoded. Return the full size, 0 if missing, as chain_storage_read does.
+static inline size_t sdk_storage_view_u64(const void *key, size_t key_size, uint64_t *value) {
+  size_t size;
+  const void *view = chain_storage_view(key, key_size, &size);
+  if (!view) {
+    // Out of view room under wasm
+    return size ? chain_storage_read(key, key_size, value, sizeof(*value)) : 0;
+  }
+  memcpy(value, view, size < sizeof(*value) ? size : sizeof(*value));
+  return size;
+}
+
+// Bump arena for dynamic buffers: sdk_alloc() moves a pointer forward and
+// sdk_context_begin() releases everything in O(1). Allocations are 8-byte
+// aligned, NULL once SDK_ARENA_SIZE bytes are used up. The write-back cache
+// keeps values too large for its entries here.
+#define SDK_ARENA_SIZE 4096
+
+static struct {
+  size_t used;
+  uint64_t bytes[SDK_ARENA_SIZE / sizeof(uint64_t)];
+} sdk_arena;
+
+static inline void *sdk_alloc(size_t size) {
+  // Checked before rounding up, which would wrap near SIZE_MAX
+  if (size > SDK_ARENA_SIZE) {
+    return NULL;
+  }
+  size = (size + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
+  if (size > SDK_ARENA_SIZE - sdk_arena.used) {
+    return NULL;
+  }
+  void *ptr = (uint8_t *)sdk_arena.bytes + sdk_arena.used;
+  sdk_arena.used += size;
+  return ptr;
+}
+
+// Position to come back to with sdk_arena_release, e.g. once per batch item
+static inline size_t sdk_arena_mark(void) {
+  return sdk_arena.used;
+}
+
+// The value at key copied into the arena in one host call, NULL if missing
+// or if it does not fit. value_size receives its full size either way.
+static inline void *sdk_storage_get(const void *key, size_t key_size, size_t *value_size) {
+  uint8_t *value = (uint8_t *)sdk_arena.bytes + sdk_arena.used;
+  *value_size = chain_storage_read(key, key_size, value, SDK_ARENA_SIZE - sdk_arena.used);
+  if (!*value_size || *value_size > SDK_ARENA_SIZE - sdk_arena.used) {
+    return NULL;
+  }
+  return sdk_alloc(*value_size);
+}
+
+// Write-back cache, so a key read or written several times in one invocation
+// crosses to the host once. Values up to SDK_CACHE_VALUE_SIZE bytes live in
+// the entry, larger ones in the arena. sdk_cache_commit() writes the dirty
+// entries back in one batch; entrypoints call it before returning, and an
+// exit discards them. Keys written through the cache must also be read
+// through it, and are not to be passed to chain_storage_delta_u64.
+#define SDK_CACHE_ENTRIES 16
+#define SDK_CACHE_KEY_SIZE 96
+#define SDK_CACHE_VALUE_SIZE 40
+
+typedef struct {
+  uint8_t dirty;
+  size_t key_size;
+  size_t value_size;
+  // bytes, or an arena allocation for a larger value
+  uint8_t *value;
+  uint8_t key[SDK_CACHE_KEY_SIZE];
+  uint8_t bytes[SDK_CACHE_VALUE_SIZE];
+} sdk_cache_entry_t;
+
+static struct {
+  size_t count;
+  sdk_cache_entry_t entries[SDK_CACHE_ENTRIES];
+} sdk_cache;
+
+static inline sdk_cache_entry_t *sdk_cache_find(const void *key, size_t key_size) {
+  for (size_t i = 0; i < sdk_cache.count; i++) {
+    sdk_cache_entry_t *entry = &sdk_cache.entries[i];
+    if (entry->key_size == key_size && memcmp(entry->key, key, key_size) == 0) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+// Write the dirty entries back to storage, they stay cached
+static inline void sdk_cache_commit(void) {
+  const void *keys[SDK_CACHE_ENTRIES];
+  size_t key_sizes[SDK_CACHE_ENTRIES];
+  const void *values[SDK_CACHE_ENTRIES];
+  size_t value_sizes[SDK_CACHE_ENTRIES];
+  size_t count = 0;
+  for (size_t i = 0; i < sdk_cache.count; i++) {
+    sdk_cache_entry_t *entry = &sdk_cache.entries[i];
+    if (entry->dirty) {
+      keys[count] = entry->key;
+      key_sizes[count] = entry->key_size;
+      values[count] = entry->value;
+      value_sizes[count] = entry->value_size;
+      entry->dirty = 0;
+      count++;
+    }
+  }
+  if (count == 1) {
+    chain_storage_set(keys[0], key_sizes[0], values[0], value_sizes[0]);
+  } else if (count) {
+    chain_storage_set_many(count, keys, key_sizes, values, value_sizes);
+  }
+}
+
+// A free entry for key, committing and emptying the cache when it is full
+static inline sdk_cache_entry_t *sdk_cache_add(const void *key, size_t key_size) {
+  if (sdk_cache.count == SDK_CACHE_ENTRIES) {
+    sdk_cache_commit();
+    sdk_cache.count = 0;
+  }
+  sdk_cache_entry_t *entry = &sdk_cache.entries[sdk_cache.count++];
+  entry->dirty = 0;
+  entry->key_size = key_size;
+  entry->value = entry->bytes;
+  memcpy(entry->key, key, key_size);
+  return entry;
+}
+
+// Same contract as chain_storage_read, served from the cache when possible
+static inline size_t sdk_cache_read(const void *key, size_t key_size, void *value, size_t value_size) {
+  if (key_size > SDK_CACHE_KEY_SIZE) {
+    return chain_storage_read(key, key_size, value, value_size);
+  }
+  sdk_cache_entry_t *entry = sdk_cache_find(key, key_size);
+  if (!entry) {
+    entry = sdk_cache_add(key, key_size);
+    entry->value_size = chain_storage_read(key, key_size, entry->bytes, SDK_CACHE_VALUE_SIZE);
+    if (entry->value_size > SDK_CACHE_VALUE_SIZE) {
+      // Too large for the entry, read it whole into the arena
+      entry->value = (uint8_t *)sdk_alloc(entry->value_size);
+      if (!entry->value) {
+        sdk_cache.count--;
+        return chain_storage_read(key, key_size, value, value_size);
+      }
+      chain_storage_read(key, key_size, entry->value, entry->value_size);
+    }
+  }
+  size_t size = value_size < entry->value_size ? value_size : entry->value_size;
+  if (size) {
+    memcpy(value, entry->value, size);
+  }
+  return entry->value_size;
+}
+
+// Same contract as chain_storage_set, written back by sdk_cache_commit()
+static inline void sdk_cache_set(const void *key, size_t key_size, const void *value, size_t value_size) {
+  uint8_t *large = NULL;
+  if (key_size <= SDK_CACHE_KEY_SIZE && value_size > SDK_CACHE_VALUE_SIZE) {
+    large = (uint8_t *)sdk_alloc(value_size);
+  }
+  if (key_size > SDK_CACHE_KEY_SIZE || (value_size > SDK_CACHE_VALUE_SIZE && !large)) {
+    // Keep the order of writes to the same key
+    sdk_cache_commit();
+    sdk_cache.count = 0;
+    chain_storage_set(key, key_size, value, value_size);
+    return;
+  }
+  sdk_cache_entry_t *entry = sdk_cache_find(key, key_size);
+  if (!entry) {
+    entry = sdk_cache_add(key, key_size);
+  }
+  entry->value = large ? large : entry->bytes;
+  if (value_size) {
+    memcpy(entry->value, value, value_size);
+  }
+  entry->value_size = value_size;
+  entry->dirty = 1;
+}
+
+// For a value the contract read itself, e.g. in a batch: keep it as a clean
+// entry, value holding all value_size bytes of it
+static inline void sdk_cache_fill(const void *key, size_t key_size, const void *value, size_t value_size) {
+  if (key_size > SDK_CACHE_KEY_SIZE || value_size > SDK_CACHE_VALUE_SIZE || sdk_cache_find(key, key_size)) {
+    return;
+  }
+  sdk_cache_entry_t *entry = sdk_cache_add(key, key_size);
+  if (value_size) {
+    memcpy(entry->value, value, value_size);
+  }
+  entry->value_size = value_size;
+}
+
+// Free everything allocated since mark. If cache entries hold values
+// allocated since, the cache is written back and emptied first.
+static inline void sdk_arena_release(size_t mark) {
+  const uint8_t *from = (const uint8_t *)sdk_arena.bytes + mark;
+  for (size_t i = 0; i < sdk_cache.count; i++) {
+    const sdk_cache_entry_t *entry = &sdk_cache.entries[i];
+    if (entry->value != entry->bytes && entry->value >= from) {
+      sdk_cache_commit();
+      sdk_cache.count = 0;
+      break;
+    }
+  }
+  sdk_arena.used = mark;
+}
+
+// Event buffer: events are encoded as the ABI lays them out, the index of
+// the event in the ABI in one byte, then its parameters in order, addresses
+// in ADDRESS_SIZE bytes and uint64 in 8 bytes little endian.
+// sdk_events_flush() hands them all to the host in one call; entrypoints
+// call it before returning, and an exit discards them.
+#define SDK_EVENTS_SIZE 1024
+
+static struct {
+  size_t size;
+  uint8_t bytes[SDK_EVENTS_SIZE];
+} sdk_events;
+
+static inline void sdk_events_flush(void) {
+  if (sdk_events.size) {
+    chain_emit_events(sdk_events.bytes, sdk_events.size);
+    sdk_events.size = 0;
+  }
+}
+
+static inline void sdk_event(uint8_t index, const uint8_t *const addresses[], size_t address_count,
+                             const uint64_t values[], size_t value_count) {
+  size_t size = 1 + address_count * ADDRESS_SIZE + value_count * sizeof(uint64_t);
+  if (sdk_events.size + size > SDK_EVENTS_SIZE) {
+    sdk_events_flush();
+  }
+  uint8_t *event = sdk_events.bytes + sdk_events.size;
+  *event++ = index;
+  for (size_t i = 0; i < address_count; i++, event += ADDRESS_SIZE) {
+    memcpy(event, addresses[i], ADDRESS_SIZE);
+  }
+  if (value_count) {
+    memcpy(event, values, value_count * sizeof(uint64_t));
+  }
+  sdk_events.size += size;
+}
+
+// Invocation context: caller, creator and owner fetched at most once per
+// invocation. Every entrypoint calls sdk_context_begin() before the others,
+// which also empties the write-back cache, the event buffer and the arena.
+#define SDK_CALLER 1
+#define SDK_CREATOR 2
+#define SDK_OWNER 4
+#define SDK_HAS_OWNER 8
+
+typedef struct {
+  uint8_t loaded;
+  uint8_t caller[ADDRESS_SIZE];
+  uint8_t creator[ADDRESS_SIZE];
+  uint8_t owner[ADDRESS_SIZE];
+} sdk_context_t;
+
+static sdk_context_t sdk_context;
+
+static inline void sdk_context_begin(void) {
+  sdk_context.loaded = 0;
+  sdk_cache.count = 0;
+  sdk_events.size = 0;
+  sdk_arena.used = 0;
+}
+
+static inline uint8_t *sdk_caller(void) {
+  if (!(sdk_context.loaded & SDK_CALLER)) {
+    chain_get_caller(sdk_context.caller);
+    sdk_context.loaded |= SDK_CALLER;
+  }
+  return sdk_context.caller;
+}
+
+static inline uint8_t *sdk_creator(void) {
+  if (!(sdk_context.loaded & SDK_CREATOR)) {
+    chain_get_creator(sdk_context.creator);
+    sdk_context.loaded |= SDK_CREATOR;
+  }
+  return sdk_context.creator;
+}
+
+// For an owner the contract read itself into sdk_context.owner, e.g. in a
+// batch, given the stored size
+static inline void sdk_owner_fetched(size_t size) {
+  sdk_context.loaded |= SDK_OWNER | (size == ADDRESS_SIZE ? SDK_HAS_OWNER : 0);
+}
+
+// The owner address stored at key, NULL if there is none
+static inline uint8_t *sdk_owner(const void *key, size_t key_size) {
+  if (!(sdk_context.loaded & SDK_OWNER)) {
+    sdk_owner_fetched(chain_storage_read(key, key_size, sdk_context.owner, ADDRESS_SIZE));
+  }
+  return sdk_context.loaded & SDK_HAS_OWNER ? sdk_context.owner : NULL;
+}
+
+// Store owner at key and keep the context in step
+static inline void sdk_set_owner(const void *key, size_t key_size, const uint8_t *owner) {
+  chain_storage_set(key, key_size, owner, ADDRESS_SIZE);
+  memmove(sdk_context.owner, owner, ADDRESS_SIZE);
+  sdk_context.loaded |= SDK_OWNER | SDK_HAS_OWNER;
+}
+
+#endif /* sdk_h */
@@ -7,23 +7,8 @@ extern Event Transfer(address from, address to, uint64_t amount, uint64_t memo);
 const char OWNER[] = "OWNER";
 const char IS_PAUSE[] = "IS_PAUSE";
 
-// sdk_storage_get
-void *sdk_storage_get(const void* key, size_t key_size) {
-  size_t size = chain_storage_size_get(key, key_size);
-  if (size == 0) {
-      return 0;
-  }
-  void *ret = (void *) malloc(size);
-  chain_storage_get(key, key_size, ret);
-  return ret;
-}
-
 int sdk_caller_is_creator() {
-  address caller;
-  address creator;
-  chain_get_caller(caller);
-  chain_get_creator(creator);
-  int n = memcmp(creator, caller, ADDRESS_SIZE);
+  int n = memcmp(sdk_creator(), sdk_caller(), ADDRESS_SIZE);
   if (n == 0) {
     return 1;
   }
@@ -31,11 +16,11 @@ int sdk_caller_is_creator() {
 }
 
 int caller_is_owner() {
-  address caller;
-  chain_get_caller(caller);
-  void *owner = sdk_storage_get(OWNER, sizeof(OWNER));
-  int n = memcmp(owner, caller, ADDRESS_SIZE);
-  free(owner);
+  uint8_t *owner = sdk_owner(OWNER, sizeof(OWNER));
+  if (!owner) {
+    return 0;
+  }
+  int n = memcmp(owner, sdk_caller(), ADDRESS_SIZE);
   if (n == 0) {
     return 1;
   }
@@ -43,14 +28,16 @@ int caller_is_owner() {
 }
 
 int set_owner(address owner) {
+  sdk_context_begin();
   if (!caller_is_owner()) {
     return -1;
   }
-  chain_storage_set(OWNER, sizeof(OWNER), owner, ADDRESS_SIZE);
+  sdk_set_owner(OWNER, sizeof(OWNER), owner);
   return 0;
 }
 
 int pause() {
+  sdk_context_begin();
   if (!caller_is_owner()) {
     return -1;
   }
@@ -60,6 +47,7 @@ int pause() {
 }
 
 int unpause() {
+  sdk_context_begin();
   if (!caller_is_owner()) {
     return -1;
   }
@@ -69,21 +57,17 @@ int unpause() {
 }
 
 int is_pausing() {
-  void *data = sdk_storage_get(IS_PAUSE, sizeof(IS_PAUSE));
-  uint8_t ret = *(uint8_t *)(data);
-  free(data);
-  return ret;
+  return sdk_storage_get_flag(IS_PAUSE, sizeof(IS_PAUSE));
 }
 
 uint64_t get_balance(address address) {
-  void *data = sdk_storage_get(address, ADDRESS_SIZE);
-  uint64_t ret = *(uint64_t *)data;
-  free(data);
-  return ret;
+  return sdk_storage_get_u64(address, ADDRESS_SIZE, 0);
 }
 
 int change_balance(address to, uint64_t amount, int sign) {
-  uint64_t to_balance = get_balance(to);
+  // Through the write-back cache, committed by the entrypoint
+  uint64_t to_balance = 0;
+  sdk_cache_read(to, ADDRESS_SIZE, &to_balance, sizeof(to_balance));
   if (sign < 0) {
     if (to_balance < amount) {
       return -1;
@@ -92,25 +76,20 @@ int change_balance(address to, uint64_t amount, int sign) {
   } else {
     to_balance += amount;
   }
-  chain_storage_set(to, ADDRESS_SIZE, &to_balance, 8);
+  sdk_cache_set(to, ADDRESS_SIZE, &to_balance, 8);
   return 0;
 }
 
 int set_owner_to_creator() {
-  address creator;
-  chain_get_creator(creator);
-  chain_storage_set(OWNER, sizeof(OWNER), creator, ADDRESS_SIZE);
+  sdk_set_owner(OWNER, sizeof(OWNER), sdk_creator());
   return 0;
 }
 
 int mint(uint64_t amount) {
+  sdk_context_begin();
   // set up genesis owner
-  if (!caller_is_owner()) {
-    void *data = sdk_storage_get(OWNER, sizeof(OWNER));
-    if (!data) {
-      set_owner_to_creator();
-    }
-    free(data);
+  if (!sdk_owner(OWNER, sizeof(OWNER))) {
+    set_owner_to_creator();
   }
 
   if (!caller_is_owner()) {
@@ -118,9 +97,9 @@ int mint(uint64_t amount) {
   }
 
   // minting
-  address caller;
-  chain_get_caller(caller);
+  uint8_t *caller = sdk_caller();
   int success = change_balance(caller, amount, 1);
+  sdk_cache_commit();
   if (success != -1) {
     Mint(caller, amount);
   }
@@ -128,15 +107,16 @@ int mint(uint64_t amount) {
 }
 
 int transfer_with_memo(address to, uint64_t amount, uint64_t memo) {
+  sdk_context_begin();
   if (is_pausing()) {
     return -1;
   }
-  address from;
-  chain_get_caller(from);
+  uint8_t *from = sdk_caller();
   int success = change_balance(from, amount, -1);
   if (success != -1) {
     success = change_balance(to, amount, 1);
   }
+  sdk_cache_commit();
   if (success != -1) {
     Transfer(from, to, amount, memo);
     return success;
@@ -11,14 +11,22 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #define WASI_EXPORT extern "C"
 #define ADDRESS_SIZE 35
 typedef uint8_t address[ADDRESS_SIZE];
 typedef int Event;
 extern size_t chain_storage_size_get(const void *, size_t);
 extern int chain_storage_get(const void *, size_t, void *);
+// Add add[i] then subtract sub[i] from the u64 stored at each key (missing
+// is 0), all or nothing. Return 0, -1 for more than 16 keys, or 1 + the
+// index of the first key that would overflow, underflow or is not a u64.
+extern int chain_storage_delta_u64(size_t count, const void *const keys[], const size_t key_sizes[],
+                                   const uint64_t add[], const uint64_t sub[]);
 extern int chain_storage_set(const void *, size_t, const void *, size_t);
 extern void chain_get_caller(address);
 extern void chain_get_creator(address);
 
+#include "../sdk/sdk.h"
+
 #endif /* vertex_h */